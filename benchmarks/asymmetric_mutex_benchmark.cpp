@@ -0,0 +1,121 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+// Measures the cost of a lock()/unlock() pair on a thread that locks a mutex 99 times
+// for every time another thread locks it, for crill::spin_mutex and
+// crill::asymmetric_mutex (locked via preferred() on the frequent side). Also
+// measures the frequent side on its own, which is the common case for a real-time
+// thread that locks the mutex a few thousand times per second.
+//
+// The 99:1 pattern runs both sides as fast as they can, so the cost of each heavy
+// fence on the rare side is shared by only 99 locks on the frequent side. On a
+// machine with a single CPU, the two threads also never run at the same time: most
+// waits are for a thread that has been preempted while holding, or announcing its
+// intent to take, the lock, and take a full yield interval of the backoff policy.
+// Those numbers measure the scheduler rather than the mutexes.
+//
+// Usage: asymmetric_mutex_benchmark [iterations]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <crill/asymmetric_mutex.h>
+#include <crill/spin_mutex.h>
+
+namespace
+{
+    struct result
+    {
+        double frequent_ns;
+        double rare_ns;
+    };
+
+    // Returns: the average duration of a lock()/unlock() pair, with no other thread
+    // using the mutex.
+    template <typename Mutex>
+    double measure_alone(Mutex& mtx, std::uint64_t iterations)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (std::uint64_t i = 0; i < iterations; ++i)
+        {
+            mtx.lock();
+            mtx.unlock();
+        }
+
+        return double(std::chrono::nanoseconds(std::chrono::steady_clock::now() - start).count()) / double(iterations);
+    }
+
+    // Returns: the average duration of a lock()/unlock() pair on either side.
+    template <typename FrequentSide, typename RareSide>
+    result measure(FrequentSide& frequent, RareSide& rare, std::uint64_t iterations)
+    {
+        std::atomic<std::uint64_t> frequent_count = 0;
+        std::atomic<bool> stop = false;
+        std::uint64_t rare_count = 0;
+        std::chrono::nanoseconds rare_time{};
+
+        std::thread rare_thread([&]{
+            std::uint64_t last = 0;
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                const std::uint64_t current = frequent_count.load(std::memory_order_relaxed);
+                if (current - last < 99)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                last = current;
+                auto start = std::chrono::steady_clock::now();
+                rare.lock();
+                rare.unlock();
+                rare_time += std::chrono::steady_clock::now() - start;
+                ++rare_count;
+            }
+        });
+
+        auto start = std::chrono::steady_clock::now();
+        for (std::uint64_t i = 0; i < iterations; ++i)
+        {
+            frequent.lock();
+            frequent.unlock();
+            frequent_count.store(i + 1, std::memory_order_relaxed);
+        }
+
+        auto frequent_time = std::chrono::steady_clock::now() - start;
+        stop = true;
+        rare_thread.join();
+
+        return {
+            double(std::chrono::nanoseconds(frequent_time).count()) / double(iterations),
+            rare_count > 0 ? double(rare_time.count()) / double(rare_count) : 0.0
+        };
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const std::uint64_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+
+    crill::spin_mutex spin;
+    const auto spin_alone = measure_alone(spin, iterations);
+    const auto spin_result = measure(spin, spin, iterations);
+
+    crill::asymmetric_mutex asymmetric;
+    auto preferred = asymmetric.preferred();
+    const auto asymmetric_alone = measure_alone(preferred, iterations);
+    const auto asymmetric_result = measure(preferred, asymmetric, iterations);
+
+    std::printf("asymmetric fence available: %s\n", crill::impl::has_asymmetric_fence ? "yes" : "no");
+    if (std::thread::hardware_concurrency() < 2)
+        std::printf("only one CPU: the 99:1 numbers are dominated by scheduling\n");
+
+    std::printf("%20s %20s %20s %20s\n", "", "frequent alone [ns]", "frequent 99:1 [ns]", "rare 99:1 [ns]");
+    std::printf("%20s %20.1f %20.1f %20.1f\n", "spin_mutex", spin_alone, spin_result.frequent_ns, spin_result.rare_ns);
+    std::printf("%20s %20.1f %20.1f %20.1f\n", "asymmetric_mutex", asymmetric_alone, asymmetric_result.frequent_ns, asymmetric_result.rare_ns);
+}
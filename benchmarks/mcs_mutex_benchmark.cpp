@@ -0,0 +1,32 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+// Measures the throughput of crill::mcs_mutex under contention, compared to
+// crill::spin_mutex (all waiters poll one cache line) and crill::ticket_spin_mutex
+// (FIFO, but all waiters still poll one cache line).
+//
+// Usage: mcs_mutex_benchmark [max_threads] [duration_ms]
+
+#include <cstdio>
+#include <crill/mcs_mutex.h>
+#include <crill/spin_mutex.h>
+#include <crill/ticket_spin_mutex.h>
+#include "throughput.h"
+
+int main(int argc, char** argv)
+{
+    using crill::benchmarks::measure_throughput;
+    const crill::benchmarks::arguments args(argc, argv);
+
+    std::printf("%8s %20s %20s %20s\n", "threads", "spin_mutex [op/s]", "ticket [op/s]", "mcs_mutex [op/s]");
+
+    for (std::size_t n = 1; n <= args.max_threads; n *= 2)
+    {
+        const double spin = measure_throughput<crill::spin_mutex>(n, args.duration);
+        const double ticket = measure_throughput<crill::ticket_spin_mutex>(n, args.duration);
+        const double mcs = measure_throughput<crill::mcs_mutex>(n, args.duration);
+        std::printf("%8zu %20.0f %20.0f %20.0f\n", n, spin, ticket, mcs);
+    }
+}
@@ -0,0 +1,56 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+// Measures the throughput of crill::spin_mutex under contention, compared to a
+// spinlock that attempts an atomic RMW on every iteration of its wait loop.
+//
+// Usage: spin_mutex_benchmark [max_threads] [duration_ms]
+
+#include <atomic>
+#include <cstdio>
+#include <crill/spin_mutex.h>
+#include "throughput.h"
+
+namespace
+{
+    // The previous design of crill::spin_mutex: every check of the predicate is
+    // an atomic_flag::test_and_set.
+    class test_and_set_mutex
+    {
+    public:
+        void lock() noexcept
+        {
+            crill::progressive_backoff_wait([this]{ return try_lock(); });
+        }
+
+        bool try_lock() noexcept
+        {
+            return !flag.test_and_set(std::memory_order_acquire);
+        }
+
+        void unlock() noexcept
+        {
+            flag.clear(std::memory_order_release);
+        }
+
+    private:
+        std::atomic_flag flag = ATOMIC_FLAG_INIT;
+    };
+}
+
+int main(int argc, char** argv)
+{
+    using crill::benchmarks::measure_throughput;
+    const crill::benchmarks::arguments args(argc, argv);
+
+    std::printf("%8s %20s %20s %8s\n", "threads", "test_and_set [op/s]", "spin_mutex [op/s]", "ratio");
+
+    for (std::size_t n = 1; n <= args.max_threads; n *= 2)
+    {
+        const double tas = measure_throughput<test_and_set_mutex>(n, args.duration);
+        const double ttas = measure_throughput<crill::spin_mutex>(n, args.duration);
+        std::printf("%8zu %20.0f %20.0f %8.2f\n", n, tas, ttas, ttas / tas);
+    }
+}
@@ -0,0 +1,73 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#ifndef CRILL_BENCHMARKS_THROUGHPUT_H
+#define CRILL_BENCHMARKS_THROUGHPUT_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace crill::benchmarks
+{
+    // Returns: the number of critical sections per second executed by num_threads
+    // threads, each repeatedly locking a Mutex and incrementing a counter.
+    template <typename Mutex>
+    double measure_throughput(std::size_t num_threads, std::chrono::milliseconds duration)
+    {
+        Mutex mtx;
+        std::uint64_t counter = 0;
+        std::atomic<bool> start = false;
+        std::atomic<bool> stop = false;
+
+        std::vector<std::thread> threads;
+        for (std::size_t i = 0; i < num_threads; ++i)
+        {
+            threads.emplace_back([&]{
+                while (!start)
+                    std::this_thread::yield();
+
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    std::scoped_lock lock(mtx);
+                    ++counter;
+                }
+            });
+        }
+
+        auto start_time = std::chrono::steady_clock::now();
+        start = true;
+        std::this_thread::sleep_for(duration);
+        stop = true;
+
+        for (auto& thread : threads)
+            thread.join();
+
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        return double(counter) / elapsed;
+    }
+
+    // Command line arguments: [max_threads] [duration_ms]
+    struct arguments
+    {
+        arguments(int argc, char** argv)
+          : max_threads(argc > 1
+                ? std::size_t(std::atoi(argv[1]))
+                : std::max<std::size_t>(std::thread::hardware_concurrency(), 2)),
+            duration(argc > 2 ? std::atoi(argv[2]) : 500)
+        {
+        }
+
+        std::size_t max_threads;
+        std::chrono::milliseconds duration;
+    };
+} // namespace crill::benchmarks
+
+#endif //CRILL_BENCHMARKS_THROUGHPUT_H
@@ -0,0 +1,111 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#ifndef CRILL_ADAPTIVE_BACKOFF_H
+#define CRILL_ADAPTIVE_BACKOFF_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <crill/progressive_backoff_wait.h>
+#include <crill/impl/cycle_counter.h>
+
+namespace crill {
+
+// crill::adaptive_backoff learns how long waits at one particular place take, and
+// spins only for as long as that is likely to pay off. It is meant to be kept next
+// to the thing being waited on, for example one per mutex or one per call site:
+//
+//    crill::spin_mutex mtx;
+//    crill::adaptive_backoff mtx_backoff;
+//
+//    crill::progressive_backoff_wait([&]{ return mtx.try_lock(); }, mtx_backoff);
+//
+// This follows the idea of glibc's adaptive mutex. Each wait first spins for up to
+// twice the current estimate plus a small minimum, and then falls through to the
+// calibrated phases of crill::progressive_backoff_wait (blocks of pauses between
+// calls to idle).
+// Afterwards, the estimate is updated with a running average (weight 1/8) of the
+// measured wait time. Waits that took longer than the yield interval of
+// crill::progressive_backoff_wait (approx. 1 ms by default) would not have been
+// worth spinning for at all, and count as zero. Waits on a lock with short hold times
+// therefore keep spinning for roughly the hold time, while waits on a lock with long
+// hold times quickly skip the learned spin phase.
+//
+// The estimate is updated with relaxed loads and stores; concurrent updates may
+// overwrite each other, which only makes the average slightly less accurate.
+class adaptive_backoff
+{
+public:
+    // Returns: the current estimate of the duration of a wait that is short enough
+    // to be worth spinning for.
+    std::chrono::nanoseconds expected_wait() const noexcept
+    {
+        return std::chrono::nanoseconds(estimate_ns.load(std::memory_order_relaxed));
+    }
+
+    // Effects: Blocks until pred returns true, spinning for the learned budget and
+    // then backing off like crill::progressive_backoff_wait, calling idle whenever
+    // its last phase runs out. Updates the estimate.
+    template <typename Predicate, typename Idle>
+    void wait(Predicate& pred, Idle& idle)
+    {
+        if (pred())
+            return;
+
+        CRILL_BACKOFF_COUNT(waits);
+        const std::uint64_t start = impl::read_cycle_counter();
+        const double pause_ns = impl::backoff_state.pause_ns.load(std::memory_order_relaxed);
+        const auto max_spin_ns = impl::backoff_state.yield_interval_ns.load(std::memory_order_relaxed);
+        const auto min_spin_ns = impl::backoff_state.pause_phase_ns.load(std::memory_order_relaxed);
+
+        const auto estimate = estimate_ns.load(std::memory_order_relaxed);
+        const auto budget_ns = std::min(max_spin_ns, 2 * estimate + min_spin_ns);
+        const auto n = std::size_t(double(budget_ns) / pause_ns);
+
+        bool done = false;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            CRILL_BACKOFF_COUNT(pause_iterations);
+            if (pred())
+            {
+                done = true;
+                break;
+            }
+
+            impl::backoff_pause();
+        }
+
+        if (!done)
+        {
+            impl::no_deadline deadline;
+            impl::progressive_backoff_wait_calibrated(pred, deadline, idle);
+        }
+
+        const double ticks_per_ns = impl::cycle_counter_ticks_per_ns.load(std::memory_order_relaxed);
+        const auto elapsed_ns = std::int64_t(double(impl::read_cycle_counter() - start) / ticks_per_ns);
+        const auto sample = elapsed_ns <= max_spin_ns ? elapsed_ns : 0;
+
+        estimate_ns.store(estimate + (sample - estimate) / 8, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<std::int64_t> estimate_ns = 0;
+};
+
+// Effects: Blocks the current thread until predicate returns true, spinning for as
+// long as the given crill::adaptive_backoff estimates to be worthwhile, and backing
+// off progressively, yielding between blocks of pauses, afterwards.
+template <typename Predicate>
+void progressive_backoff_wait(Predicate&& pred, adaptive_backoff& backoff)
+{
+    impl::yield_idle idle;
+    backoff.wait(pred, idle);
+}
+
+} // namespace crill
+
+#endif //CRILL_ADAPTIVE_BACKOFF_H
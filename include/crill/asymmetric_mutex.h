@@ -0,0 +1,164 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#ifndef CRILL_ASYMMETRIC_MUTEX_H
+#define CRILL_ASYMMETRIC_MUTEX_H
+
+#include <atomic>
+#include <crill/progressive_backoff_wait.h>
+#include <crill/spin_mutex.h>
+#include <crill/impl/asymmetric_fence.h>
+
+namespace crill
+{
+
+// crill::asymmetric_mutex is a spinlock for the case where one thread, the preferred
+// thread, locks it very often, and other threads lock it rarely. For example, a
+// real-time thread that locks it in every audio callback, and a UI thread that
+// occasionally changes a parameter.
+//
+// The preferred thread locks it through preferred(), which does not need an atomic
+// read-modify-write operation or a memory fence: locking is a plain store, a compiler
+// barrier and a load, and unlocking is a plain store. Other threads lock it through
+// lock(), which is much more expensive than locking crill::spin_mutex, because it has
+// to make up for the missing fence on the preferred thread with an asymmetric fence:
+// on Linux, a membarrier system call, which interrupts all running threads of the
+// process; on Windows, FlushProcessWriteBuffers. On other platforms, and on Linux
+// before 4.14, both sides use a full fence instead, and there is no gain.
+//
+// Each lock() on another thread also interrupts the preferred thread if it is
+// running, and keeps it from taking the lock for the duration of the system call.
+// The mutex therefore pays off when the other threads lock it rarely in time (say,
+// tens of times per second), not merely rarely compared to the preferred thread: if
+// both sides lock it back to back, the cost of the heavy fence is shared by too few
+// locks on the preferred side.
+//
+//    crill::asymmetric_mutex mtx;
+//
+//    // preferred thread:
+//    std::scoped_lock lock(mtx.preferred());
+//
+//    // any other thread:
+//    std::scoped_lock lock(mtx);
+//
+// Both mtx.preferred() and mtx meet the standard C++ requirements for mutex
+// [thread.req.lockable.req] and can therefore be used with std::scoped_lock and
+// std::unique_lock. At most one thread at a time may use preferred(). Other threads
+// are serialised among themselves with a crill::spin_mutex before competing with the
+// preferred thread.
+//
+// If both sides try to lock at the same time, the preferred thread backs off and
+// waits with crill::progressive_backoff_wait. The preferred side's try_lock() and
+// unlock() are wait-free, so is the other side's unlock().
+template <typename BackoffPolicy = default_progressive>
+class basic_asymmetric_mutex
+{
+public:
+    // The interface for the preferred thread.
+    class preferred_side
+    {
+    public:
+        // Effects: Acquires the lock. If necessary, blocks until the lock can be acquired.
+        // Preconditions: The current thread is the only one using preferred(), and does
+        // not already hold the lock.
+        void lock() noexcept
+        {
+            if (try_lock())
+                return;
+
+            progressive_backoff_wait<BackoffPolicy>([this]{
+                return !mtx.other_flag.load(std::memory_order_relaxed) && try_lock();
+            });
+        }
+
+        // Effects: Attempts to acquire the lock without blocking.
+        // Returns: true if the lock was acquired, false otherwise.
+        // Preconditions: The current thread is the only one using preferred().
+        // Non-blocking guarantees: wait-free.
+        bool try_lock() noexcept
+        {
+            mtx.preferred_flag.store(true, std::memory_order_relaxed);
+            impl::asymmetric_fence_light();
+
+            if (!mtx.other_flag.load(std::memory_order_acquire))
+                return true;
+
+            mtx.preferred_flag.store(false, std::memory_order_release);
+            return false;
+        }
+
+        // Effects: Releases the lock.
+        // Preconditions: The lock is being held by the current thread, through preferred().
+        // Non-blocking guarantees: wait-free.
+        void unlock() noexcept
+        {
+            mtx.preferred_flag.store(false, std::memory_order_release);
+        }
+
+    private:
+        friend class basic_asymmetric_mutex;
+        explicit preferred_side(basic_asymmetric_mutex& mtx) noexcept : mtx(mtx) {}
+        basic_asymmetric_mutex& mtx;
+    };
+
+    // Returns: the interface for the preferred thread.
+    preferred_side preferred() noexcept
+    {
+        return preferred_side(*this);
+    }
+
+    // Effects: Acquires the lock from a thread other than the preferred thread. If
+    // necessary, blocks until the lock can be acquired.
+    // Preconditions: The current thread does not already hold the lock.
+    void lock() noexcept
+    {
+        others.lock();
+        other_flag.store(true, std::memory_order_relaxed);
+        impl::asymmetric_fence_heavy();
+
+        progressive_backoff_wait<BackoffPolicy>([this]{
+            return !preferred_flag.load(std::memory_order_acquire);
+        });
+    }
+
+    // Effects: Attempts to acquire the lock from a thread other than the preferred
+    // thread without blocking (but with a system call on some platforms).
+    // Returns: true if the lock was acquired, false otherwise.
+    bool try_lock() noexcept
+    {
+        if (!others.try_lock())
+            return false;
+
+        other_flag.store(true, std::memory_order_relaxed);
+        impl::asymmetric_fence_heavy();
+
+        if (!preferred_flag.load(std::memory_order_acquire))
+            return true;
+
+        other_flag.store(false, std::memory_order_release);
+        others.unlock();
+        return false;
+    }
+
+    // Effects: Releases the lock acquired with lock() or try_lock().
+    // Preconditions: The lock is being held by the current thread.
+    // Non-blocking guarantees: wait-free.
+    void unlock() noexcept
+    {
+        other_flag.store(false, std::memory_order_release);
+        others.unlock();
+    }
+
+private:
+    std::atomic<bool> preferred_flag = false;
+    std::atomic<bool> other_flag = false;
+    spin_mutex others;
+};
+
+using asymmetric_mutex = basic_asymmetric_mutex<>;
+
+} // namespace crill
+
+#endif //CRILL_ASYMMETRIC_MUTEX_H
@@ -0,0 +1,224 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#ifndef CRILL_BACKOFF_POLICY_H
+#define CRILL_BACKOFF_POLICY_H
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <type_traits>
+#include <crill/platform.h>
+#include <crill/impl/progressive_backoff_wait_impl.h>
+
+namespace crill {
+
+// Backoff policies determine how crill::progressive_backoff_wait, and the
+// primitives built on it (crill::spin_mutex, crill::seqlock_object::load),
+// spin while waiting. The policy is a template parameter, so choosing one has no
+// runtime overhead.
+//
+// A backoff policy is a type with a static member function
+//
+//    template <typename Predicate, typename Deadline, typename Idle>
+//    static bool wait(Predicate& pred, Deadline& deadline, Idle& idle);
+//
+// that returns true as soon as pred() returns true, and false if
+// deadline.expired() returns true first or if the policy gives up. Whenever the
+// policy has spun for long enough that giving up the CPU is appropriate, it should
+// call idle(pred), which yields by default, or parks the thread if a
+// crill::parking_spot is used.
+// The policy decides how often deadline.expired() is checked; the check is free
+// for untimed waits.
+
+// The default policy: spinning without pause for a few iterations, then with
+// single pauses for approx. 400 ns, then with blocks of pauses for approx. 1 ms
+// between calls to idle. The durations are calibrated at startup; see
+// crill::progressive_backoff_timings.
+struct default_progressive
+{
+    template <typename Predicate, typename Deadline, typename Idle>
+    static bool wait(Predicate& pred, Deadline& deadline, Idle& idle)
+    {
+        return impl::progressive_backoff_wait_calibrated(pred, deadline, idle);
+    }
+};
+
+// Like default_progressive, but never gives up the CPU: it keeps spinning in the
+// last phase instead of calling idle. Use this on a real-time thread that must not
+// enter the scheduler (for example, under SCHED_FIFO, where yielding either does
+// nothing or hands the CPU to a thread of the same priority), and only if the
+// awaited condition is guaranteed to become true soon.
+struct realtime_never_yield
+{
+    template <typename Predicate, typename Deadline, typename Idle>
+    static bool wait(Predicate& pred, Deadline& deadline, Idle&)
+    {
+        impl::no_idle no_idle;
+        return impl::progressive_backoff_wait_calibrated(pred, deadline, no_idle);
+    }
+};
+
+// Spins for a fixed number of iterations, known at compile time, and never gives
+// up the CPU: SpinCount iterations without pause, then PauseCount iterations with a
+// single pause, then PauseBlockCount iterations with a block of pauses (one wfe on
+// ARM). If the predicate is still false after that, the wait fails; use
+// crill::progressive_backoff_try_wait to find out. The predicate is evaluated at
+// most SpinCount + PauseCount + PauseBlockCount times.
+//
+// This is meant for real-time threads which must never enter the scheduler because
+// of a wait, and which have a fallback for when the awaited condition does not
+// become true in time. The worst-case duration of the wait depends on the cost of
+// a pause instruction, see crill::get_progressive_backoff_timings. With the default
+// counts, it is approx. 1000 pauses (on the order of 10 - 150 us on Intel).
+template <std::size_t SpinCount = 5, std::size_t PauseCount = 10, std::size_t PauseBlockCount = 100>
+struct realtime_bounded
+{
+    template <typename Predicate, typename Deadline, typename Idle>
+    static bool wait(Predicate& pred, Deadline& deadline, Idle&)
+    {
+        CRILL_BACKOFF_COUNT(waits);
+
+        for (std::size_t i = 0; i < SpinCount; ++i)
+        {
+            CRILL_BACKOFF_COUNT(spin_iterations);
+            if (pred())
+                return true;
+        }
+
+        for (std::size_t i = 0; i < PauseCount; ++i)
+        {
+            CRILL_BACKOFF_COUNT(pause_iterations);
+            if (pred())
+                return true;
+
+            impl::backoff_pause();
+        }
+
+        for (std::size_t i = 0; i < PauseBlockCount; ++i)
+        {
+            CRILL_BACKOFF_COUNT(pause_block_iterations);
+            if (pred())
+                return true;
+
+            if (deadline.expired())
+                return false;
+
+            impl::backoff_pause_block();
+        }
+
+        return false;
+    }
+};
+
+// Spins only briefly (approx. 10 us), then gives up the CPU. Unless the idle
+// action does something other than yielding (such as crill::parking_spot), it
+// sleeps instead, starting at 10 us and doubling up to 1 ms, so that a waiting
+// thread uses almost no CPU time. This trades wakeup latency for power: a timed
+// wait may return up to the current sleep duration late.
+struct low_power
+{
+    template <typename Predicate, typename Deadline, typename Idle>
+    static bool wait(Predicate& pred, Deadline& deadline, Idle& idle)
+    {
+        const double pause_ns = impl::backoff_state.pause_ns.load(std::memory_order_relaxed);
+        const auto n = std::max<std::size_t>(std::size_t(spin_time.count() / pause_ns), 1);
+
+        CRILL_BACKOFF_COUNT(waits);
+
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            CRILL_BACKOFF_COUNT(pause_iterations);
+            if (pred())
+                return true;
+
+            if (deadline.expired())
+                return false;
+
+            impl::backoff_pause();
+        }
+
+        auto sleep_time = min_sleep_time;
+        while (true)
+        {
+            if (pred())
+                return true;
+
+            if (deadline.expired())
+                return false;
+
+            CRILL_BACKOFF_COUNT(yields);
+            if constexpr (impl::idle_can_sleep<Idle>::value)
+            {
+                idle.sleep(pred, sleep_time);
+                sleep_time = std::min(sleep_time * 2, max_sleep_time);
+            }
+            else
+            {
+                idle(pred);
+            }
+        }
+    }
+
+private:
+    static constexpr std::chrono::nanoseconds spin_time = std::chrono::microseconds(10);
+    static constexpr std::chrono::microseconds min_sleep_time = std::chrono::microseconds(10);
+    static constexpr std::chrono::microseconds max_sleep_time = std::chrono::milliseconds(1);
+};
+
+// Exponential backoff with random jitter: after each failed check of the
+// predicate, pauses for a random number of pause instructions below a limit that
+// doubles every time, up to approx. 10 us. Calls idle after approx. 1 ms, like
+// default_progressive. Randomisation prevents many threads that started waiting
+// at the same time from checking the predicate (and, for a spinlock, attempting
+// an atomic RMW) in lockstep.
+struct exponential_randomized
+{
+    template <typename Predicate, typename Deadline, typename Idle>
+    static bool wait(Predicate& pred, Deadline& deadline, Idle& idle)
+    {
+        const double pause_ns = impl::backoff_state.pause_ns.load(std::memory_order_relaxed);
+        const auto max_pauses = std::max<std::size_t>(std::size_t(max_backoff_time.count() / pause_ns), 1);
+        const auto idle_pauses = std::max<std::size_t>(
+            std::size_t(double(impl::backoff_state.yield_interval_ns.load(std::memory_order_relaxed)) / pause_ns), 1);
+
+        auto random_state = std::uint32_t(impl::read_cycle_counter()) | 1;
+        std::size_t limit = 1;
+        std::size_t pauses_since_idle = 0;
+
+        CRILL_BACKOFF_COUNT(waits);
+
+        while (true)
+        {
+            CRILL_BACKOFF_COUNT(pause_block_iterations);
+            if (pred())
+                return true;
+
+            if (deadline.expired())
+                return false;
+
+            const std::size_t n = 1 + impl::next_random(random_state) % limit;
+            for (std::size_t i = 0; i < n; ++i)
+                impl::backoff_pause();
+
+            limit = std::min(limit * 2, max_pauses);
+            pauses_since_idle += n;
+
+            if (pauses_since_idle >= idle_pauses)
+            {
+                CRILL_BACKOFF_COUNT(yields);
+                idle(pred);
+                pauses_since_idle = 0;
+            }
+        }
+    }
+
+private:
+    static constexpr std::chrono::nanoseconds max_backoff_time = std::chrono::microseconds(10);
+};
+
+} // namespace crill
+
+#endif //CRILL_BACKOFF_POLICY_H
@@ -0,0 +1,81 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#ifndef CRILL_BACKOFF_TELEMETRY_H
+#define CRILL_BACKOFF_TELEMETRY_H
+
+#include <crill/impl/backoff_telemetry_impl.h>
+
+namespace crill {
+
+// Backoff telemetry counts, per thread, how many iterations crill::progressive_backoff_wait
+// and the primitives built on it spend in each phase of the backoff, and how often
+// the spin budget is used up so that the thread yields, sleeps, or parks. This is
+// useful to tune spin budgets and backoff policies from real traffic.
+//
+// Telemetry is disabled by default and costs nothing then: all counting compiles
+// away and the functions below return zeros. To enable it, define
+// CRILL_BACKOFF_TELEMETRY. This must be done consistently for the whole program
+// (for example, on the compiler command line), as it changes inline functions.
+//
+// When enabled, each counted event is a relaxed load and store to a thread-local
+// counter, so counting does not add contention between threads. Reading the counters
+// is lock-free and can be done from any thread at any time.
+
+#ifdef CRILL_BACKOFF_TELEMETRY
+inline constexpr bool backoff_telemetry_enabled = true;
+#else
+inline constexpr bool backoff_telemetry_enabled = false;
+#endif
+
+// A snapshot of backoff telemetry counters; see impl::backoff_counts for the fields.
+using backoff_telemetry_snapshot = impl::backoff_counts;
+
+// Returns: the sum of the counters of all threads, including threads that have exited.
+// Non-blocking guarantees: lock-free.
+inline backoff_telemetry_snapshot get_backoff_telemetry() noexcept
+{
+    backoff_telemetry_snapshot total;
+
+  #ifdef CRILL_BACKOFF_TELEMETRY
+    for (auto* node = impl::backoff_counters_head.load(std::memory_order_acquire); node != nullptr; node = node->next)
+    {
+        auto counts = impl::read_backoff_counters(*node);
+        total.waits += counts.waits;
+        total.spin_iterations += counts.spin_iterations;
+        total.pause_iterations += counts.pause_iterations;
+        total.pause_block_iterations += counts.pause_block_iterations;
+        total.yields += counts.yields;
+        total.parks += counts.parks;
+    }
+  #endif
+
+    return total;
+}
+
+// Returns: the counters of the current thread.
+// Non-blocking guarantees: wait-free, except on the first call on a thread.
+inline backoff_telemetry_snapshot get_this_thread_backoff_telemetry() noexcept
+{
+    backoff_telemetry_snapshot result;
+
+  #ifdef CRILL_BACKOFF_TELEMETRY
+    auto& owner = impl::this_thread_backoff_counters_owner();
+    auto counts = impl::read_backoff_counters(*owner.node);
+    const auto& previous = owner.counts_of_previous_owners;
+    result.waits = counts.waits - previous.waits;
+    result.spin_iterations = counts.spin_iterations - previous.spin_iterations;
+    result.pause_iterations = counts.pause_iterations - previous.pause_iterations;
+    result.pause_block_iterations = counts.pause_block_iterations - previous.pause_block_iterations;
+    result.yields = counts.yields - previous.yields;
+    result.parks = counts.parks - previous.parks;
+  #endif
+
+    return result;
+}
+
+} // namespace crill
+
+#endif //CRILL_BACKOFF_TELEMETRY_H
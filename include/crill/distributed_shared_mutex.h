@@ -0,0 +1,157 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#ifndef CRILL_DISTRIBUTED_SHARED_MUTEX_H
+#define CRILL_DISTRIBUTED_SHARED_MUTEX_H
+
+#include <atomic>
+#include <cstdint>
+#include <crill/platform.h>
+#include <crill/progressive_backoff_wait.h>
+#include <crill/impl/thread_index.h>
+
+namespace crill
+{
+
+// crill::distributed_shared_mutex is a reader-writer lock for data that is read very
+// frequently, on many cores at the same time, and written rarely ("big-reader lock").
+//
+// Instead of a single reader count, which all readers would have to modify and which
+// therefore becomes a bottleneck with many concurrent readers, it has NumSlots reader
+// counts, each in its own cache line(s). Each thread is assigned one of them on first
+// use, round-robin. As long as there are at most NumSlots reading threads, readers
+// therefore do not share any cache line that they write to. In exchange, lock() has
+// to check every slot, and the mutex occupies NumSlots + 1 times
+// CRILL_DESTRUCTIVE_INTERFERENCE_SIZE bytes (approx. 8 kB with the default of 64 slots
+// on x86-64).
+//
+// crill::distributed_shared_mutex meets the standard C++ requirements for shared
+// mutex [thread.sharedmutex.requirements] and can therefore be used with
+// std::shared_lock, std::scoped_lock and std::unique_lock as a drop-in replacement
+// for std::shared_mutex. A shared lock must be released on the thread that acquired
+// it.
+//
+// Writers are preferred: a writer first announces itself, which turns away new
+// readers, and then waits with crill::progressive_backoff_wait until every slot is
+// zero. Readers that find a writer waiting or active wait with
+// crill::progressive_backoff_wait as well. try_lock_shared() and unlock_shared() are
+// wait-free, and so are try_lock() and unlock().
+//
+// crill::distributed_shared_mutex is an alias for
+// crill::basic_distributed_shared_mutex with the default backoff policy and number
+// of slots.
+template <typename BackoffPolicy = default_progressive, std::size_t NumSlots = 64>
+class basic_distributed_shared_mutex
+{
+public:
+    static_assert(NumSlots > 0);
+
+    // Effects: Acquires exclusive ownership. If necessary, blocks until no other thread
+    // holds the lock.
+    // Preconditions: The current thread does not already hold the lock.
+    void lock() noexcept
+    {
+        progressive_backoff_wait<BackoffPolicy>([this]{
+            return !writer.load(std::memory_order_relaxed) && !writer.exchange(true, std::memory_order_seq_cst);
+        });
+
+        for (auto& slot : slots)
+        {
+            progressive_backoff_wait<BackoffPolicy>([&slot]{
+                return slot.readers.load(std::memory_order_seq_cst) == 0;
+            });
+        }
+    }
+
+    // Effects: Attempts to acquire exclusive ownership without blocking. Fails if any
+    // other thread holds the lock.
+    // Returns: true if the lock was acquired, false otherwise.
+    // Non-blocking guarantees: wait-free.
+    bool try_lock() noexcept
+    {
+        if (writer.exchange(true, std::memory_order_seq_cst))
+            return false;
+
+        for (auto& slot : slots)
+        {
+            if (slot.readers.load(std::memory_order_seq_cst) != 0)
+            {
+                writer.store(false, std::memory_order_release);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Effects: Releases exclusive ownership.
+    // Preconditions: The current thread holds exclusive ownership.
+    // Non-blocking guarantees: wait-free.
+    void unlock() noexcept
+    {
+        writer.store(false, std::memory_order_release);
+    }
+
+    // Effects: Acquires shared ownership. If necessary, blocks until no thread holds
+    // or is waiting for exclusive ownership.
+    // Preconditions: The current thread does not already hold the lock.
+    void lock_shared() noexcept
+    {
+        if (try_lock_shared())
+            return;
+
+        progressive_backoff_wait<BackoffPolicy>([this]{
+            return !writer.load(std::memory_order_relaxed) && try_lock_shared();
+        });
+    }
+
+    // Effects: Attempts to acquire shared ownership without blocking. Fails if a
+    // thread holds or is waiting for exclusive ownership.
+    // Returns: true if the lock was acquired, false otherwise.
+    // Non-blocking guarantees: wait-free.
+    bool try_lock_shared() noexcept
+    {
+        auto& readers = this_thread_slot().readers;
+
+        // Announce the reader before checking for a writer, while the writer announces
+        // itself before checking the readers (both seq_cst), so that at least one of
+        // them sees the other.
+        readers.fetch_add(1, std::memory_order_seq_cst);
+        if (!writer.load(std::memory_order_seq_cst))
+            return true;
+
+        readers.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Effects: Releases shared ownership.
+    // Preconditions: The current thread holds shared ownership.
+    // Non-blocking guarantees: wait-free.
+    void unlock_shared() noexcept
+    {
+        this_thread_slot().readers.fetch_sub(1, std::memory_order_release);
+    }
+
+private:
+    struct alignas(CRILL_DESTRUCTIVE_INTERFERENCE_SIZE) slot_type
+    {
+        std::atomic<std::uint32_t> readers = 0;
+    };
+
+    slot_type& this_thread_slot() noexcept
+    {
+        return slots[impl::this_thread_index() % NumSlots];
+    }
+
+    alignas(CRILL_DESTRUCTIVE_INTERFERENCE_SIZE) std::atomic<bool> writer = false;
+    slot_type slots[NumSlots];
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+};
+
+using distributed_shared_mutex = basic_distributed_shared_mutex<>;
+
+} // namespace crill
+
+#endif //CRILL_DISTRIBUTED_SHARED_MUTEX_H
@@ -0,0 +1,234 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#ifndef CRILL_FLAT_COMBINING_H
+#define CRILL_FLAT_COMBINING_H
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <crill/platform.h>
+#include <crill/progressive_backoff_wait.h>
+#include <crill/spin_mutex.h>
+#include <crill/impl/thread_index.h>
+
+namespace crill
+{
+
+// crill::flat_combining protects an object of type T, like a T together with a
+// Mutex, but performs better under heavy contention. Operations on the object are
+// passed to apply() as callables taking a T&.
+//
+// With a plain mutex, every thread that performs an operation first has to move the
+// cache lines holding the mutex and the object to its own core. With flat combining,
+// a thread that finds the mutex taken instead publishes its operation in a slot, and
+// the thread holding the mutex (the combiner) executes all published operations in
+// one batch, while the object stays in its cache. Publishing threads wait for the
+// result with crill::progressive_backoff_wait, and take over as the combiner if the
+// mutex becomes free while their operation is still pending.
+//
+//    crill::flat_combining<order_book> book;
+//    auto fill = book.apply([&](order_book& b) { return b.insert(order); });
+//
+// Operations of other threads may therefore execute on any thread, in any order, and
+// must not depend on thread-local state. They may throw; the exception is rethrown
+// from apply() on the thread that published the operation.
+//
+// There are MaxThreads slots, each in its own cache line(s) (see
+// CRILL_DESTRUCTIVE_INTERFERENCE_SIZE). Threads are spread over the slots
+// round-robin; if all slots are taken, a thread waits for the mutex directly.
+template <typename T, typename Mutex = spin_mutex, std::size_t MaxThreads = 64>
+class flat_combining
+{
+public:
+    static_assert(MaxThreads > 0);
+
+    // Effects: Constructs the protected object from args.
+    template <typename... Args>
+    explicit flat_combining(Args&&... args)
+      : object(std::forward<Args>(args)...)
+    {
+    }
+
+    flat_combining(const flat_combining&) = delete;
+    flat_combining& operator=(const flat_combining&) = delete;
+
+    // Effects: Calls op with a reference to the protected object, either on the current
+    // thread or on a thread that is currently combining, with exclusive access to it.
+    // Returns: the result of op.
+    template <typename Op>
+    std::invoke_result_t<Op&, T&> apply(Op&& op)
+    {
+        using result_type = std::invoke_result_t<Op&, T&>;
+        static_assert(!std::is_reference_v<result_type>, "operations must return by value");
+
+        if (try_lock_combiner())
+        {
+            combine_guard guard(*this);
+            return op(object);
+        }
+
+        operation<Op, result_type> pending_op(op);
+        slot* s = publish(pending_op);
+        if (s == nullptr)
+        {
+            // all slots taken: wait for the lock and become the combiner; the guard
+            // releases the lock
+            mtx.lock();
+            combiner_active.store(true, std::memory_order_relaxed);
+            combine_guard guard(*this);
+            return op(object);
+        }
+
+        progressive_backoff_wait([&]{
+            if (s->state.load(std::memory_order_acquire) == slot_done)
+                return true;
+
+            if (!combiner_active.load(std::memory_order_relaxed) && try_lock_combiner())
+            {
+                // our own operation is still pending, so it is executed in the batch
+                combine_guard guard(*this);
+                return true;
+            }
+
+            return false;
+        });
+
+        s->state.store(slot_free, std::memory_order_release);
+        return pending_op.get();
+    }
+
+private:
+    enum : std::uint32_t { slot_free, slot_claimed, slot_pending, slot_done };
+
+    struct alignas(CRILL_DESTRUCTIVE_INTERFERENCE_SIZE) slot
+    {
+        std::atomic<std::uint32_t> state = slot_free;
+        void (*execute)(void*, T&) = nullptr;
+        void* op = nullptr;
+    };
+
+    // A published operation, living on the stack of the publishing thread.
+    template <typename Op, typename Result>
+    struct operation
+    {
+        explicit operation(Op& op) : op(op) {}
+
+        static void execute(void* self, T& object)
+        {
+            auto& o = *static_cast<operation*>(self);
+            try
+            {
+                if constexpr (std::is_void_v<Result>)
+                    o.op(object);
+                else
+                    o.result.emplace(o.op(object));
+            }
+            catch (...)
+            {
+                o.exception = std::current_exception();
+            }
+        }
+
+        Result get()
+        {
+            if (exception)
+                std::rethrow_exception(exception);
+
+            if constexpr (!std::is_void_v<Result>)
+                return std::move(*result);
+        }
+
+        Op& op;
+        std::conditional_t<std::is_void_v<Result>, bool, std::optional<Result>> result{};
+        std::exception_ptr exception;
+    };
+
+    // Executes the published operations and releases the mutex when destroyed, so
+    // that the operations of other threads are not lost if an operation on the
+    // combining thread throws.
+    struct combine_guard
+    {
+        explicit combine_guard(flat_combining& fc) : fc(fc) {}
+
+        ~combine_guard()
+        {
+            fc.combine();
+            fc.combiner_active.store(false, std::memory_order_relaxed);
+            fc.mtx.unlock();
+        }
+
+        flat_combining& fc;
+    };
+
+    bool try_lock_combiner()
+    {
+        if (!mtx.try_lock())
+            return false;
+
+        combiner_active.store(true, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Returns: the slot in which op was published, or nullptr if all slots were taken.
+    template <typename Op, typename Result>
+    slot* publish(operation<Op, Result>& op) noexcept
+    {
+        const std::size_t first = impl::this_thread_index();
+        for (std::size_t i = 0; i < MaxThreads; ++i)
+        {
+            slot& s = slots[(first + i) % MaxThreads];
+            std::uint32_t expected = slot_free;
+            if (s.state.load(std::memory_order_relaxed) == slot_free
+                && s.state.compare_exchange_strong(expected, slot_claimed, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                s.execute = &operation<Op, Result>::execute;
+                s.op = &op;
+                s.state.store(slot_pending, std::memory_order_release);
+                return &s;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // Effects: Executes all published operations. Rescans as long as new operations
+    // are found, up to a few times, so that the combiner does not get stuck serving
+    // other threads forever.
+    // Preconditions: The current thread holds the mutex.
+    void combine()
+    {
+        for (int pass = 0; pass < max_passes; ++pass)
+        {
+            bool found = false;
+            for (slot& s : slots)
+            {
+                if (s.state.load(std::memory_order_acquire) != slot_pending)
+                    continue;
+
+                s.execute(s.op, object);
+                s.state.store(slot_done, std::memory_order_release);
+                found = true;
+            }
+
+            if (!found)
+                return;
+        }
+    }
+
+    static constexpr int max_passes = 3;
+
+    Mutex mtx;
+    std::atomic<bool> combiner_active = false;
+    T object;
+    slot slots[MaxThreads];
+};
+
+} // namespace crill
+
+#endif //CRILL_FLAT_COMBINING_H
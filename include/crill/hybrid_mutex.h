@@ -0,0 +1,114 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#ifndef CRILL_HYBRID_MUTEX_H
+#define CRILL_HYBRID_MUTEX_H
+
+#include <atomic>
+#include <cstdint>
+#include <crill/progressive_backoff_wait.h>
+#include <crill/impl/futex.h>
+
+namespace crill
+{
+
+// crill::hybrid_mutex is a mutex that spins like crill::spin_mutex, and goes to sleep
+// if the spin budget is used up, like std::mutex. Unlike std::mutex, its unlock()
+// never makes a system call unless another thread is actually asleep waiting for the
+// lock. It can therefore be shared between a real-time thread, which only ever holds
+// it briefly and needs a cheap unlock(), and background threads, which may have to
+// wait for a long time and should not keep a core busy while doing so.
+//
+// crill::hybrid_mutex meets the standard C++ requirements for mutex
+// [thread.req.lockable.req] and can therefore be used with std::scoped_lock
+// and std::unique_lock as a drop-in replacement for std::mutex.
+//
+// The lock word is 0 if the mutex is unlocked, 1 if it is locked, and 2 if it is
+// locked and threads may be asleep waiting for it (see Ulrich Drepper, "Futexes Are
+// Tricky"). lock() waits with crill::progressive_backoff_wait, and whenever the
+// backoff policy would yield, it marks the word as 2 and sleeps on it instead: on a
+// futex on Linux, with WaitOnAddress on Windows, and on a condition variable
+// elsewhere. unlock() resets the word to 0 and only wakes up a thread if it was 2.
+// With the default policy, a thread spins for approx. 1 ms before going to sleep;
+// use crill::low_power to go to sleep sooner. Backoff policies that never give up the
+// CPU, such as crill::realtime_never_yield, never sleep.
+//
+// try_lock() is wait-free. unlock() is wait-free if no thread is asleep waiting for
+// the lock, which is always the case if all threads that lock the mutex use a
+// policy that never gives up the CPU.
+//
+// crill::hybrid_mutex is an alias for crill::basic_hybrid_mutex with the default
+// backoff policy. Use crill::basic_hybrid_mutex directly to choose a different policy
+// from crill/backoff_policy.h.
+template <typename BackoffPolicy = default_progressive>
+class basic_hybrid_mutex
+{
+public:
+    // Effects: Acquires the lock. If necessary, blocks until the lock can be acquired.
+    // Preconditions: The current thread does not already hold the lock.
+    void lock() noexcept
+    {
+        if (try_lock())
+            return;
+
+        // After sleeping, other threads may still be asleep, so the lock has to be
+        // taken as 2 to make sure that unlock() wakes them up.
+        std::uint32_t locked_value = locked;
+
+        auto pred = [&]{
+            std::uint32_t expected = unlocked;
+            return word.load(std::memory_order_relaxed) == unlocked
+                && word.compare_exchange_strong(expected, locked_value, std::memory_order_acquire, std::memory_order_relaxed);
+        };
+
+        auto sleep = [&](auto&) {
+            locked_value = locked_with_sleepers;
+
+            std::uint32_t expected = locked;
+            if (word.compare_exchange_strong(expected, locked_with_sleepers, std::memory_order_relaxed)
+                || expected == locked_with_sleepers)
+            {
+                CRILL_BACKOFF_COUNT(parks);
+                impl::futex_wait(word, locked_with_sleepers);
+            }
+        };
+
+        impl::no_deadline deadline;
+        while (!BackoffPolicy::wait(pred, deadline, sleep))
+            /* policy gave up, start over */;
+    }
+
+    // Effects: Attempts to acquire the lock without blocking.
+    // Returns: true if the lock was acquired, false otherwise.
+    // Non-blocking guarantees: wait-free.
+    bool try_lock() noexcept
+    {
+        std::uint32_t expected = unlocked;
+        return word.compare_exchange_strong(expected, locked, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    // Effects: Releases the lock, and wakes up one thread that is asleep waiting for
+    // it, if any.
+    // Preconditions: The lock is being held by the current thread.
+    // Non-blocking guarantees: wait-free if no thread is asleep waiting for the lock.
+    void unlock() noexcept
+    {
+        if (word.exchange(unlocked, std::memory_order_release) == locked_with_sleepers)
+            impl::futex_wake_one(word);
+    }
+
+private:
+    static constexpr std::uint32_t unlocked = 0;
+    static constexpr std::uint32_t locked = 1;
+    static constexpr std::uint32_t locked_with_sleepers = 2;
+
+    std::atomic<std::uint32_t> word = unlocked;
+};
+
+using hybrid_mutex = basic_hybrid_mutex<>;
+
+} // namespace crill
+
+#endif //CRILL_HYBRID_MUTEX_H
@@ -0,0 +1,78 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#ifndef CRILL_ASYMMETRIC_FENCE_H
+#define CRILL_ASYMMETRIC_FENCE_H
+
+#include <atomic>
+
+#if defined(__linux__)
+  #include <linux/membarrier.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+#elif defined(_WIN32)
+  // Declared here rather than including <windows.h>, see crill/impl/futex.h.
+  extern "C" __declspec(dllimport) void __stdcall FlushProcessWriteBuffers();
+#endif
+
+// An asymmetric fence is a pair of a light fence, which is only a compiler barrier,
+// and a heavy fence, which makes the OS interrupt all other threads of the process
+// that are currently running and execute a full memory barrier on their cores. A
+// light fence on one thread and a heavy fence on another together order memory like
+// a pair of std::atomic_thread_fence(std::memory_order_seq_cst). This moves the whole
+// cost of synchronisation to the side that executes the heavy fence.
+//
+// The heavy fence is implemented with membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED) on
+// Linux 4.14 and later, and with FlushProcessWriteBuffers on Windows. Otherwise, both
+// fences are std::atomic_thread_fence(std::memory_order_seq_cst).
+namespace crill::impl
+{
+  #if defined(__linux__)
+    // Returns: true if the process could register for private expedited membarrier.
+    inline bool register_membarrier() noexcept
+    {
+        const long commands = syscall(SYS_membarrier, MEMBARRIER_CMD_QUERY, 0);
+        if (commands < 0 || (commands & MEMBARRIER_CMD_PRIVATE_EXPEDITED) == 0)
+            return false;
+
+        return syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0;
+    }
+
+    inline const bool has_asymmetric_fence = register_membarrier();
+  #elif defined(_WIN32)
+    inline constexpr bool has_asymmetric_fence = true;
+  #else
+    inline constexpr bool has_asymmetric_fence = false;
+  #endif
+
+    // Effects: The cheap side of an asymmetric fence.
+    inline void asymmetric_fence_light() noexcept
+    {
+        if (has_asymmetric_fence)
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+        else
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    // Effects: The expensive side of an asymmetric fence. Makes a system call if the
+    // platform supports asymmetric fences.
+    inline void asymmetric_fence_heavy() noexcept
+    {
+        if (has_asymmetric_fence)
+        {
+          #if defined(__linux__)
+            syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0);
+          #elif defined(_WIN32)
+            FlushProcessWriteBuffers();
+          #endif
+        }
+        else
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+} // namespace crill::impl
+
+#endif //CRILL_ASYMMETRIC_FENCE_H
@@ -0,0 +1,128 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#ifndef CRILL_BACKOFF_TELEMETRY_IMPL_H
+#define CRILL_BACKOFF_TELEMETRY_IMPL_H
+
+#include <atomic>
+#include <cstdint>
+
+// CRILL_BACKOFF_COUNT(counter) increments the given counter of the current thread
+// if CRILL_BACKOFF_TELEMETRY is defined, and expands to nothing otherwise.
+#ifdef CRILL_BACKOFF_TELEMETRY
+  #define CRILL_BACKOFF_COUNT(counter) \
+    ::crill::impl::increment_backoff_counter(::crill::impl::this_thread_backoff_counters().counter)
+#else
+  #define CRILL_BACKOFF_COUNT(counter) ((void)0)
+#endif
+
+namespace crill::impl
+{
+    struct backoff_counters
+    {
+        std::atomic<std::uint64_t> waits = 0;
+        std::atomic<std::uint64_t> spin_iterations = 0;
+        std::atomic<std::uint64_t> pause_iterations = 0;
+        std::atomic<std::uint64_t> pause_block_iterations = 0;
+        std::atomic<std::uint64_t> yields = 0;
+        std::atomic<std::uint64_t> parks = 0;
+    };
+
+    // A plain copy of backoff_counters.
+    struct backoff_counts
+    {
+        // Number of waits started (a policy that gives up and starts over counts twice).
+        std::uint64_t waits = 0;
+        // Iterations spent spinning on the predicate without pausing.
+        std::uint64_t spin_iterations = 0;
+        // Iterations spent in the phase with a single pause per iteration.
+        std::uint64_t pause_iterations = 0;
+        // Iterations spent in the last phase (block of pauses, tpause, umwait, or wfe).
+        std::uint64_t pause_block_iterations = 0;
+        // Number of times the spin budget was used up and the thread gave up the CPU
+        // (by yielding, sleeping, or parking).
+        std::uint64_t yields = 0;
+        // Number of times a thread actually went to sleep on a crill::parking_spot.
+        std::uint64_t parks = 0;
+    };
+
+    inline backoff_counts read_backoff_counters(const backoff_counters& counters) noexcept
+    {
+        return {
+            counters.waits.load(std::memory_order_relaxed),
+            counters.spin_iterations.load(std::memory_order_relaxed),
+            counters.pause_iterations.load(std::memory_order_relaxed),
+            counters.pause_block_iterations.load(std::memory_order_relaxed),
+            counters.yields.load(std::memory_order_relaxed),
+            counters.parks.load(std::memory_order_relaxed)
+        };
+    }
+
+#ifdef CRILL_BACKOFF_TELEMETRY
+    // The counters of one thread. Nodes are kept in a lock-free, append-only list
+    // so that they can be summed up from any thread. When a thread exits, its node
+    // is released and can be claimed by a new thread; its counts are kept.
+    struct backoff_counters_node : backoff_counters
+    {
+        std::atomic<bool> in_use = true;
+        backoff_counters_node* next = nullptr;
+    };
+
+    inline std::atomic<backoff_counters_node*> backoff_counters_head = nullptr;
+
+    inline backoff_counters_node* acquire_backoff_counters_node()
+    {
+        for (auto* node = backoff_counters_head.load(std::memory_order_acquire); node != nullptr; node = node->next)
+        {
+            bool expected = false;
+            if (node->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire, std::memory_order_relaxed))
+                return node;
+        }
+
+        auto* node = new backoff_counters_node;
+        node->next = backoff_counters_head.load(std::memory_order_relaxed);
+        while (!backoff_counters_head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+            /* retry */;
+
+        return node;
+    }
+
+    struct backoff_counters_owner
+    {
+        backoff_counters_owner()
+          : node(acquire_backoff_counters_node()),
+            counts_of_previous_owners(read_backoff_counters(*node))
+        {
+        }
+
+        ~backoff_counters_owner()
+        {
+            node->in_use.store(false, std::memory_order_release);
+        }
+
+        backoff_counters_node* node;
+        backoff_counts counts_of_previous_owners;
+    };
+
+    inline backoff_counters_owner& this_thread_backoff_counters_owner()
+    {
+        thread_local backoff_counters_owner owner;
+        return owner;
+    }
+
+    inline backoff_counters& this_thread_backoff_counters()
+    {
+        return *this_thread_backoff_counters_owner().node;
+    }
+
+    // Only the owning thread writes to its counters, so no RMW is needed.
+    inline void increment_backoff_counter(std::atomic<std::uint64_t>& counter) noexcept
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+#endif
+} // namespace crill::impl
+
+#endif //CRILL_BACKOFF_TELEMETRY_IMPL_H
@@ -0,0 +1,120 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#ifndef CRILL_CYCLE_COUNTER_H
+#define CRILL_CYCLE_COUNTER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <crill/platform.h>
+
+#if CRILL_INTEL
+  #if defined(_MSC_VER)
+    #include <intrin.h>
+  #else
+    #include <x86intrin.h>
+  #endif
+#elif CRILL_ARM_64BIT && defined(_MSC_VER)
+  #include <intrin.h>
+#endif
+
+namespace crill::impl
+{
+    // Returns: the current value of a cheap, monotonic, constant-rate hardware counter:
+    // the TSC on Intel, and the virtual counter (CNTVCT_EL0) on ARM.
+    //
+    // Reading it does not serialise the instruction stream, so it is only suitable for
+    // measurements and deadlines with a granularity well above a few dozen cycles.
+    inline std::uint64_t read_cycle_counter() noexcept
+    {
+      #if CRILL_INTEL
+        return __rdtsc();
+      #elif CRILL_ARM_64BIT && defined(_MSC_VER)
+        return std::uint64_t(_ReadStatusReg(ARM64_SYSREG(3, 3, 14, 0, 2))); // CNTVCT_EL0
+      #elif CRILL_ARM_64BIT
+        std::uint64_t value;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+        return value;
+      #else
+        #error "Platform not supported!"
+      #endif
+    }
+
+  #if CRILL_ARM_64BIT
+    // The frequency of the virtual counter is reported by the hardware.
+    inline double read_cycle_counter_ticks_per_ns() noexcept
+    {
+      #if defined(_MSC_VER)
+        auto frequency = std::uint64_t(_ReadStatusReg(ARM64_SYSREG(3, 3, 14, 0, 0))); // CNTFRQ_EL0
+      #else
+        std::uint64_t frequency;
+        asm volatile("mrs %0, cntfrq_el0" : "=r"(frequency));
+      #endif
+        return double(frequency) * 1e-9;
+    }
+
+    inline std::atomic<double> cycle_counter_ticks_per_ns = read_cycle_counter_ticks_per_ns();
+  #else
+    // The TSC frequency is not reported reliably, so this is a guess until
+    // calibrate_cycle_counter has measured it.
+    inline std::atomic<double> cycle_counter_ticks_per_ns = 3.0;
+  #endif
+
+    // A pair of readings of the cycle counter and of std::chrono::steady_clock.
+    struct cycle_counter_sample
+    {
+        static cycle_counter_sample now() noexcept
+        {
+            return { read_cycle_counter(), std::chrono::steady_clock::now() };
+        }
+
+        std::uint64_t ticks;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    // Returns: the frequency of the cycle counter derived from two samples taken some
+    // time apart, or the current value of cycle_counter_ticks_per_ns if that is not
+    // possible or not necessary. The further apart they are, the more accurate the
+    // result.
+    inline double measure_cycle_counter_ticks_per_ns(const cycle_counter_sample& start, const cycle_counter_sample& end) noexcept
+    {
+      #if CRILL_INTEL
+        auto elapsed_ns = std::chrono::duration<double, std::nano>(end.time - start.time).count();
+        if (elapsed_ns > 0 && end.ticks > start.ticks)
+            return double(end.ticks - start.ticks) / elapsed_ns;
+      #else
+        (void)start;
+        (void)end;
+      #endif
+        return cycle_counter_ticks_per_ns.load(std::memory_order_relaxed);
+    }
+
+    // Effects: Derives the frequency of the cycle counter from two samples taken some
+    // time apart. The further apart they are, the more accurate the result.
+    inline void calibrate_cycle_counter(const cycle_counter_sample& start, const cycle_counter_sample& end) noexcept
+    {
+        cycle_counter_ticks_per_ns.store(measure_cycle_counter_ticks_per_ns(start, end), std::memory_order_relaxed);
+    }
+
+    // Returns: the number of cycle counter ticks corresponding to the given duration,
+    // saturated to the range of std::uint64_t.
+    template <typename Rep, typename Period>
+    std::uint64_t to_cycle_counter_ticks(const std::chrono::duration<Rep, Period>& d) noexcept
+    {
+        double ticks = std::chrono::duration<double, std::nano>(d).count()
+                     * cycle_counter_ticks_per_ns.load(std::memory_order_relaxed);
+
+        if (ticks <= 0)
+            return 0;
+
+        if (ticks >= 1.8e19)
+            return UINT64_MAX;
+
+        return std::uint64_t(ticks);
+    }
+} // namespace crill::impl
+
+#endif //CRILL_CYCLE_COUNTER_H
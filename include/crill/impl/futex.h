@@ -0,0 +1,144 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#ifndef CRILL_FUTEX_H
+#define CRILL_FUTEX_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__linux__)
+  #include <cerrno>
+  #include <system_error>
+  #include <linux/futex.h>
+  #include <pthread.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+#elif defined(_WIN32)
+  #pragma comment(lib, "Synchronization.lib")
+  // Declared here rather than including <windows.h>, which would define min and max
+  // as macros in every file that includes a crill header.
+  extern "C" __declspec(dllimport) int __stdcall WaitOnAddress(volatile void*, void*, std::size_t, unsigned long);
+  extern "C" __declspec(dllimport) void __stdcall WakeByAddressSingle(void*);
+  extern "C" __declspec(dllimport) void __stdcall WakeByAddressAll(void*);
+#else
+  #include <condition_variable>
+  #include <mutex>
+#endif
+
+// Minimal wrappers around the operating system's facility to block a thread until a
+// 32-bit word in memory changes: futex on Linux, WaitOnAddress on Windows. On other
+// platforms, it is emulated with a small table of condition variables.
+namespace crill::impl
+{
+    static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t));
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+
+  #if !defined(__linux__) && !defined(_WIN32)
+    struct futex_bucket
+    {
+        std::mutex mtx;
+        std::condition_variable cv;
+    };
+
+    inline futex_bucket& get_futex_bucket(const void* address) noexcept
+    {
+        static futex_bucket buckets[64];
+        return buckets[(reinterpret_cast<std::uintptr_t>(address) / sizeof(std::uint32_t)) % 64];
+    }
+  #endif
+
+    // Effects: Blocks the current thread if word still contains expected, until it is
+    // woken up by futex_wake. May return spuriously.
+    inline void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected) noexcept
+    {
+      #if defined(__linux__)
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+      #elif defined(_WIN32)
+        WaitOnAddress(&word, &expected, sizeof(expected), 0xFFFFFFFF /* INFINITE */);
+      #else
+        auto& bucket = get_futex_bucket(&word);
+        std::unique_lock lock(bucket.mtx);
+        if (word.load(std::memory_order_relaxed) == expected)
+            bucket.cv.wait(lock);
+      #endif
+    }
+
+    // Effects: Wakes up at least one thread blocked in futex_wait on word.
+    inline void futex_wake_one(std::atomic<std::uint32_t>& word) noexcept
+    {
+      #if defined(__linux__)
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+      #elif defined(_WIN32)
+        WakeByAddressSingle(&word);
+      #else
+        // the bucket may be shared with other words, so everyone has to be woken up
+        auto& bucket = get_futex_bucket(&word);
+        { std::lock_guard lock(bucket.mtx); }
+        bucket.cv.notify_all();
+      #endif
+    }
+
+    // Effects: Wakes up all threads blocked in futex_wait on word.
+    inline void futex_wake_all(std::atomic<std::uint32_t>& word) noexcept
+    {
+      #if defined(__linux__)
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+      #elif defined(_WIN32)
+        WakeByAddressAll(&word);
+      #else
+        auto& bucket = get_futex_bucket(&word);
+        { std::lock_guard lock(bucket.mtx); }
+        bucket.cv.notify_all();
+      #endif
+    }
+
+  #if defined(__linux__)
+    // Cached result of gettid for the current thread, or 0 if not yet known.
+    inline thread_local std::uint32_t cached_thread_tid = 0;
+
+    // Returns: the kernel thread id of the current thread, as stored in the word of a
+    // priority-inheritance futex.
+    inline std::uint32_t this_thread_tid() noexcept
+    {
+        if (cached_thread_tid == 0)
+        {
+            // The child of a fork runs on a new kernel thread, so it must not keep the
+            // id cached by the thread that called fork.
+            static const bool reset_in_child = pthread_atfork(nullptr, nullptr, []{ cached_thread_tid = 0; }) == 0;
+            (void)reset_in_child;
+
+            cached_thread_tid = std::uint32_t(syscall(SYS_gettid));
+        }
+
+        return cached_thread_tid;
+    }
+
+    // Effects: Acquires the priority-inheritance futex word, blocking if necessary.
+    // While blocked, the kernel boosts the owner to the priority of the highest-priority
+    // waiter. Returns once the word holds the current thread's id.
+    // Throws: std::system_error if the kernel refuses to acquire the word, for example
+    // because the current thread already owns it (EDEADLK), the owner has died
+    // (EOWNERDEAD), or PI futexes are not supported (ENOSYS).
+    inline void futex_lock_pi(std::atomic<std::uint32_t>& word)
+    {
+        while (syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_LOCK_PI_PRIVATE, 0, nullptr, nullptr, 0) != 0)
+        {
+            if (errno != EINTR && errno != EAGAIN)
+                throw std::system_error(errno, std::generic_category(), "FUTEX_LOCK_PI");
+        }
+    }
+
+    // Effects: Releases the priority-inheritance futex word held by the current thread,
+    // and hands it to the highest-priority waiter.
+    inline void futex_unlock_pi(std::atomic<std::uint32_t>& word) noexcept
+    {
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_UNLOCK_PI_PRIVATE, 0, nullptr, nullptr, 0);
+    }
+  #endif
+} // namespace crill::impl
+
+#endif //CRILL_FUTEX_H
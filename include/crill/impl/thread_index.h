@@ -0,0 +1,26 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#ifndef CRILL_THREAD_INDEX_H
+#define CRILL_THREAD_INDEX_H
+
+#include <atomic>
+#include <cstddef>
+
+namespace crill::impl
+{
+    inline std::atomic<std::size_t> next_thread_index = 0;
+
+    // Returns: an index that is assigned to the current thread on first use, and that
+    // differs between threads that called this function one after the other. Used to
+    // spread threads over per-thread slots.
+    inline std::size_t this_thread_index() noexcept
+    {
+        thread_local const std::size_t index = next_thread_index.fetch_add(1, std::memory_order_relaxed);
+        return index;
+    }
+} // namespace crill::impl
+
+#endif //CRILL_THREAD_INDEX_H
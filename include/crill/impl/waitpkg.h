@@ -0,0 +1,70 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#ifndef CRILL_WAITPKG_H
+#define CRILL_WAITPKG_H
+
+#include <cstdint>
+#include <crill/platform.h>
+
+// The WAITPKG instructions (UMONITOR, UMWAIT, TPAUSE) are available on Intel CPUs
+// since Tremont and Alder Lake / Sapphire Rapids. The compiler needs to know about
+// them, but we do not want to require compiling with -mwaitpkg, so the wrappers
+// below enable them per function and are only called after checking CPUID.
+#if CRILL_INTEL && !defined(_MSC_VER) && defined(__has_include)
+  #if __has_include(<waitpkgintrin.h>)
+    #define CRILL_HAS_WAITPKG 1
+  #endif
+#endif
+
+#if CRILL_HAS_WAITPKG
+  #include <cpuid.h>
+  #include <immintrin.h>
+#endif
+
+namespace crill::impl
+{
+  #if CRILL_HAS_WAITPKG
+    // Returns: true if the CPU supports the WAITPKG instructions (CPUID.7.0:ECX[5]).
+    inline bool detect_waitpkg() noexcept
+    {
+        unsigned int eax, ebx, ecx, edx;
+        if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+            return false;
+
+        return (ecx & (1u << 5)) != 0;
+    }
+
+    inline const bool has_waitpkg = detect_waitpkg();
+
+    // Selects the C0.1 state for umwait and tpause, which saves less power than C0.2
+    // but wakes up faster.
+    inline constexpr unsigned int waitpkg_c01 = 1;
+
+    // Effects: Arms address monitoring hardware on the cache line containing address.
+    __attribute__((target("waitpkg"))) inline void umonitor(const volatile void* address) noexcept
+    {
+        _umonitor(const_cast<void*>(address));
+    }
+
+    // Effects: Waits in C0.1 until the monitored cache line is written to, until the
+    // TSC reaches deadline, or until the OS-imposed time limit is reached.
+    __attribute__((target("waitpkg"))) inline void umwait(std::uint64_t deadline) noexcept
+    {
+        _umwait(waitpkg_c01, deadline);
+    }
+
+    // Effects: Waits in C0.1 until the TSC reaches deadline or until the OS-imposed
+    // time limit is reached.
+    __attribute__((target("waitpkg"))) inline void tpause(std::uint64_t deadline) noexcept
+    {
+        _tpause(waitpkg_c01, deadline);
+    }
+  #else
+    inline constexpr bool has_waitpkg = false;
+  #endif
+} // namespace crill::impl
+
+#endif //CRILL_WAITPKG_H
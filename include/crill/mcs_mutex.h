@@ -0,0 +1,205 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#ifndef CRILL_MCS_MUTEX_H
+#define CRILL_MCS_MUTEX_H
+
+#include <atomic>
+#include <utility>
+#include <crill/platform.h>
+#include <crill/progressive_backoff_wait.h>
+
+namespace crill
+{
+namespace impl
+{
+    // A waiter in the queue of a crill::basic_mcs_mutex. Each node occupies its own
+    // cache line(s), so that a waiting thread only polls memory that no other waiting
+    // thread touches.
+    struct alignas(CRILL_DESTRUCTIVE_INTERFERENCE_SIZE) mcs_node
+    {
+        std::atomic<mcs_node*> next = nullptr;
+        std::atomic<bool> locked = false;
+
+        // Used by mcs_node_pool only.
+        mcs_node* next_free = nullptr;
+    };
+
+    // A per-thread free list of nodes. Nodes are allocated when a thread holds more
+    // crill::basic_mcs_mutex locks at the same time than it ever did before, and
+    // freed when the thread exits.
+    class mcs_node_pool
+    {
+    public:
+        ~mcs_node_pool()
+        {
+            while (head != nullptr)
+                delete std::exchange(head, head->next_free);
+        }
+
+        mcs_node* acquire()
+        {
+            if (head == nullptr)
+                return new mcs_node;
+
+            return std::exchange(head, head->next_free);
+        }
+
+        void release(mcs_node* node) noexcept
+        {
+            node->next_free = head;
+            head = node;
+        }
+
+    private:
+        mcs_node* head = nullptr;
+    };
+
+    inline mcs_node_pool& this_thread_mcs_node_pool()
+    {
+        thread_local mcs_node_pool pool;
+        return pool;
+    }
+} // namespace impl
+
+// crill::mcs_mutex is a queue-based spinlock (Mellor-Crummey and Scott): each
+// waiting thread appends a node to a queue, and then spins on a flag in its own
+// node, which the previous thread in the queue clears when it releases the lock.
+// Unlike with crill::spin_mutex, where all waiting threads poll the same cache line,
+// releasing the lock therefore only touches the cache line of the next waiter, and
+// the lock keeps scaling to many cores. Like crill::ticket_spin_mutex, it grants the
+// lock in FIFO order.
+//
+// The cost is a more expensive uncontended lock()/unlock() than crill::spin_mutex,
+// and a larger footprint: the mutex and every node occupy their own cache line(s)
+// (see CRILL_DESTRUCTIVE_INTERFERENCE_SIZE).
+//
+// crill::mcs_mutex meets the standard C++ requirements for mutex
+// [thread.req.lockable.req] and can therefore be used with std::scoped_lock
+// and std::unique_lock as a drop-in replacement for std::mutex. These overloads take
+// a node from a thread-local pool. The first time a thread holds n locks of type
+// crill::basic_mcs_mutex simultaneously, lock() and try_lock() allocate a node, so
+// to keep a real-time thread free of allocations, lock the mutex once on that
+// thread up front, or use the overloads taking an explicit node.
+//
+// lock() waits with crill::progressive_backoff_wait. try_lock() is wait-free.
+// unlock() is wait-free unless another thread is in the middle of joining the
+// queue, in which case it waits for that thread to finish doing so.
+//
+// crill::mcs_mutex is an alias for crill::basic_mcs_mutex with the default backoff
+// policy. Use crill::basic_mcs_mutex directly to choose a different policy from
+// crill/backoff_policy.h.
+template <typename BackoffPolicy = default_progressive>
+class basic_mcs_mutex
+{
+public:
+    using node = impl::mcs_node;
+
+    // Effects: Acquires the lock, using a node from a thread-local pool. If necessary,
+    // blocks until all threads that called lock() earlier have released the lock.
+    // Preconditions: The current thread does not already hold the lock.
+    void lock()
+    {
+        auto* n = impl::this_thread_mcs_node_pool().acquire();
+        lock(*n);
+        holder = n;
+    }
+
+    // Effects: Attempts to acquire the lock without blocking, using a node from a
+    // thread-local pool.
+    // Returns: true if the lock was acquired, false otherwise.
+    // Non-blocking guarantees: wait-free (after the first call on a thread).
+    bool try_lock()
+    {
+        auto& pool = impl::this_thread_mcs_node_pool();
+        auto* n = pool.acquire();
+        if (!try_lock(*n))
+        {
+            pool.release(n);
+            return false;
+        }
+
+        holder = n;
+        return true;
+    }
+
+    // Effects: Releases a lock acquired with lock() or try_lock(), and returns the
+    // node to the thread-local pool.
+    // Preconditions: The lock is being held by the current thread.
+    void unlock() noexcept
+    {
+        auto* n = holder;
+        unlock(*n);
+        impl::this_thread_mcs_node_pool().release(n);
+    }
+
+    // Effects: Acquires the lock using the given node. If necessary, blocks until all
+    // threads that called lock() earlier have released the lock.
+    // Preconditions: The current thread does not already hold the lock. The node is
+    // not in use by another lock, and outlives the matching call to unlock(n).
+    void lock(node& n) noexcept
+    {
+        n.next.store(nullptr, std::memory_order_relaxed);
+        n.locked.store(true, std::memory_order_relaxed);
+
+        // acq_rel: release publishes the initialised node to the thread that links to
+        // it, acquire synchronises with the previous holder if the queue was empty.
+        node* prev = tail.exchange(&n, std::memory_order_acq_rel);
+        if (prev == nullptr)
+            return;
+
+        prev->next.store(&n, std::memory_order_release);
+        progressive_backoff_wait<BackoffPolicy>([&n]{
+            return !n.locked.load(std::memory_order_acquire);
+        });
+    }
+
+    // Effects: Attempts to acquire the lock using the given node without blocking.
+    // Fails if the lock is held, or if other threads are waiting for it.
+    // Returns: true if the lock was acquired, false otherwise.
+    // Non-blocking guarantees: wait-free.
+    bool try_lock(node& n) noexcept
+    {
+        n.next.store(nullptr, std::memory_order_relaxed);
+        node* expected = nullptr;
+        return tail.compare_exchange_strong(expected, &n, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    // Effects: Releases a lock acquired with the given node, and hands it to the
+    // thread that has waited longest.
+    // Preconditions: The lock is being held by the current thread using node n.
+    void unlock(node& n) noexcept
+    {
+        node* next = n.next.load(std::memory_order_acquire);
+        if (next == nullptr)
+        {
+            node* expected = &n;
+            if (tail.compare_exchange_strong(expected, nullptr, std::memory_order_release, std::memory_order_relaxed))
+                return;
+
+            // Another thread has swapped itself into the tail, but has not yet linked
+            // its node to ours
+            progressive_backoff_wait<BackoffPolicy>([&]{
+                next = n.next.load(std::memory_order_acquire);
+                return next != nullptr;
+            });
+        }
+
+        next->locked.store(false, std::memory_order_release);
+    }
+
+private:
+    alignas(CRILL_DESTRUCTIVE_INTERFERENCE_SIZE) std::atomic<node*> tail = nullptr;
+    // Only accessed by the thread holding the lock. Kept off the cache line of tail,
+    // which waiting threads write to when joining the queue.
+    alignas(CRILL_DESTRUCTIVE_INTERFERENCE_SIZE) node* holder = nullptr;
+    static_assert(std::atomic<node*>::is_always_lock_free);
+};
+
+using mcs_mutex = basic_mcs_mutex<>;
+
+} // namespace crill
+
+#endif //CRILL_MCS_MUTEX_H
@@ -0,0 +1,107 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#ifndef CRILL_PARKING_SPOT_H
+#define CRILL_PARKING_SPOT_H
+
+#include <atomic>
+#include <cstdint>
+#include <crill/progressive_backoff_wait.h>
+#include <crill/impl/futex.h>
+
+namespace crill {
+
+// crill::parking_spot allows a thread waiting in crill::progressive_backoff_wait to
+// stop spinning and go to sleep after the spin budget has been used up, instead of
+// yielding in a loop forever. This is useful for threads that may wait for a long
+// time, such as idle worker threads, which would otherwise keep a core busy.
+//
+// The parked thread is woken up by calling notify_one() or notify_all() on the same
+// parking_spot after making the predicate true. notify_one() and notify_all() do not
+// make a system call if no thread is currently parked, so they are cheap to call
+// from a thread that only rarely has to wake anyone up. However, they are not
+// wait-free if a thread is parked, and should therefore not be called on a
+// real-time thread if the other side may be parked.
+//
+// On Linux, the parked thread blocks on a futex. On Windows, it uses WaitOnAddress.
+// On other platforms, it blocks on a condition variable.
+class parking_spot
+{
+public:
+    // Effects: Wakes up at least one thread parked on this parking_spot, if any.
+    // Must be called after making the predicate of the parked thread true.
+    void notify_one() noexcept
+    {
+        if (has_parked_threads())
+        {
+            epoch.fetch_add(1, std::memory_order_relaxed);
+            impl::futex_wake_one(epoch);
+        }
+    }
+
+    // Effects: Wakes up all threads parked on this parking_spot.
+    // Must be called after making the predicate of the parked threads true.
+    void notify_all() noexcept
+    {
+        if (has_parked_threads())
+        {
+            epoch.fetch_add(1, std::memory_order_relaxed);
+            impl::futex_wake_all(epoch);
+        }
+    }
+
+    // Effects: Blocks the current thread until pred returns true or until the
+    // thread is woken up by notify_one() or notify_all(). May return spuriously.
+    template <typename Predicate>
+    void park(Predicate& pred)
+    {
+        // Read the epoch before registering as parked: any notify that sees us
+        // registered will then change the epoch and prevent us from going to sleep.
+        std::uint32_t current_epoch = epoch.load(std::memory_order_relaxed);
+
+        parked.fetch_add(1, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (!pred())
+        {
+            CRILL_BACKOFF_COUNT(parks);
+            impl::futex_wait(epoch, current_epoch);
+        }
+
+        parked.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+private:
+    bool has_parked_threads() const noexcept
+    {
+        // Pairs with the fence in park(): either the notifier sees the parked thread,
+        // or the parked thread sees the predicate becoming true.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return parked.load(std::memory_order_acquire) != 0;
+    }
+
+    std::atomic<std::uint32_t> epoch = 0;
+    std::atomic<std::uint32_t> parked = 0;
+};
+
+// Effects: Blocks the current thread until predicate returns true, like
+// crill::progressive_backoff_wait. But instead of yielding after the spin budget
+// has been used up, parks the thread on the given parking_spot until another
+// thread calls notify_one() or notify_all() on it.
+//
+// Backoff policies that never give up the CPU, such as
+// crill::realtime_never_yield, never park.
+template <typename BackoffPolicy = default_progressive, typename Predicate>
+void progressive_backoff_wait(Predicate&& pred, parking_spot& spot)
+{
+    impl::no_deadline deadline;
+    auto park = [&spot](auto& p) { spot.park(p); };
+    while (!BackoffPolicy::wait(pred, deadline, park))
+        /* policy gave up, start over */;
+}
+
+} // namespace crill
+
+#endif //CRILL_PARKING_SPOT_H
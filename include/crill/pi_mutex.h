@@ -0,0 +1,94 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#ifndef CRILL_PI_MUTEX_H
+#define CRILL_PI_MUTEX_H
+
+#include <atomic>
+#include <cstdint>
+#include <crill/impl/futex.h>
+
+// crill::pi_mutex relies on priority-inheritance futexes and is only available on
+// Linux. CRILL_HAS_PI_MUTEX is defined to 1 if it is available.
+#if defined(__linux__)
+  #define CRILL_HAS_PI_MUTEX 1
+#endif
+
+namespace crill
+{
+
+#if CRILL_HAS_PI_MUTEX
+// crill::pi_mutex is a mutex with priority inheritance: while a higher-priority
+// thread is blocked waiting for the lock, the kernel raises the priority of the
+// thread holding it to that of the waiter. This prevents priority inversion, where a
+// real-time thread (say, SCHED_FIFO) waits for a lock held by a normal thread that
+// does not get to run because medium-priority threads are keeping the CPU busy.
+// A spinlock such as crill::spin_mutex cannot prevent this: spinning only keeps the
+// waiting thread busy, and the holder does not run any sooner.
+//
+// crill::pi_mutex meets the standard C++ requirements for mutex
+// [thread.req.lockable.req] and can therefore be used with std::scoped_lock
+// and std::unique_lock as a drop-in replacement for std::mutex.
+//
+// The lock word holds the kernel thread id of the owner, or 0 if the mutex is
+// unlocked. Locking and unlocking an uncontended mutex is a single compare-exchange
+// in user space. If the mutex is held, lock() immediately blocks in the kernel
+// (FUTEX_LOCK_PI), which then boosts the owner; it does not spin first. If threads
+// are blocked, unlock() hands the lock over to the highest-priority one in the
+// kernel (FUTEX_UNLOCK_PI).
+//
+// try_lock() is wait-free. unlock() is wait-free if no thread is blocked waiting for
+// the lock, and otherwise makes a system call.
+//
+// Unlike the other crill mutexes, crill::pi_mutex must be unlocked on the thread that
+// locked it, as the kernel checks ownership. It is not recursive; locking it again on
+// the same thread is undefined behaviour.
+class pi_mutex
+{
+public:
+    // Effects: Acquires the lock. If necessary, blocks until the lock can be acquired,
+    // raising the priority of the current owner to that of the current thread if that
+    // is higher.
+    // Preconditions: The current thread does not already hold the lock.
+    // Throws: std::system_error if the kernel fails to acquire the lock on behalf of
+    // the current thread; the lock is not held in that case.
+    void lock()
+    {
+        if (try_lock())
+            return;
+
+        impl::futex_lock_pi(word);
+    }
+
+    // Effects: Attempts to acquire the lock without blocking.
+    // Returns: true if the lock was acquired, false otherwise.
+    // Non-blocking guarantees: wait-free.
+    bool try_lock() noexcept
+    {
+        std::uint32_t expected = 0;
+        return word.compare_exchange_strong(expected, impl::this_thread_tid(), std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    // Effects: Releases the lock. If threads are blocked waiting for it, hands it over
+    // to the one with the highest priority.
+    // Preconditions: The lock is being held by the current thread.
+    // Non-blocking guarantees: wait-free if no thread is blocked waiting for the lock.
+    void unlock() noexcept
+    {
+        // If threads are blocked, the kernel has set FUTEX_WAITERS in the word, so this
+        // fails and the kernel has to do the handover.
+        std::uint32_t expected = impl::this_thread_tid();
+        if (!word.compare_exchange_strong(expected, 0, std::memory_order_release, std::memory_order_relaxed))
+            impl::futex_unlock_pi(word);
+    }
+
+private:
+    std::atomic<std::uint32_t> word = 0;
+};
+#endif
+
+} // namespace crill
+
+#endif //CRILL_PI_MUTEX_H
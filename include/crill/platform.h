@@ -10,7 +10,7 @@
   #define CRILL_ARM 1
   #define CRILL_32BIT 1
   #define CRILL_ARM_32BIT 1
-#elif defined (__arm64__)
+#elif defined (__arm64__) || defined (__aarch64__) || defined (_M_ARM64)
   #define CRILL_ARM 1
   #define CRILL_64BIT 1
   #define CRILL_ARM_64BIT 1
@@ -24,4 +24,14 @@
   #define CRILL_INTEL_64BIT 1
 #endif
 
+// The minimum offset between two objects to avoid false sharing, like
+// std::hardware_destructive_interference_size (which not all standard libraries
+// provide, and which may differ between translation units). Intel CPUs prefetch
+// cache lines in pairs, and Apple Silicon has 128-byte cache lines.
+#if CRILL_INTEL_64BIT || (CRILL_ARM_64BIT && defined(__APPLE__))
+  #define CRILL_DESTRUCTIVE_INTERFERENCE_SIZE 128
+#else
+  #define CRILL_DESTRUCTIVE_INTERFERENCE_SIZE 64
+#endif
+
 #endif //CRILL_PLATFORM_H
@@ -0,0 +1,314 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#ifndef CRILL_PROFILED_MUTEX_H
+#define CRILL_PROFILED_MUTEX_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <crill/impl/cycle_counter.h>
+
+namespace crill
+{
+namespace impl
+{
+    // The statistics of all crill::profiled mutexes with the same name. Records are
+    // kept in a lock-free, append-only list so that they can be read from any thread.
+    struct lock_profile_node
+    {
+        const char* name = nullptr;
+        std::atomic<std::uint64_t> acquisitions = 0;
+        std::atomic<std::uint64_t> contended_acquisitions = 0;
+        std::atomic<std::uint64_t> failed_try_locks = 0;
+        std::atomic<std::uint64_t> wait_ticks = 0;
+        std::atomic<std::uint64_t> max_wait_ticks = 0;
+        std::atomic<std::uint64_t> hold_ticks = 0;
+        lock_profile_node* next = nullptr;
+    };
+
+    inline std::atomic<lock_profile_node*> lock_profile_head = nullptr;
+
+    // Readings of the cycle counter and std::chrono::steady_clock taken when the first
+    // record was created. The report measures the frequency of the cycle counter
+    // against them, so that durations are accurate even if the cycle counter was never
+    // calibrated (see crill::calibrate_progressive_backoff).
+    inline const cycle_counter_sample& lock_profile_epoch() noexcept
+    {
+        static const auto epoch = cycle_counter_sample::now();
+        return epoch;
+    }
+
+    // Returns: the first node in the list up to (excluding) end with the
+    // given name, or nullptr if there is none.
+    inline lock_profile_node* find_lock_profile_node(lock_profile_node* begin, lock_profile_node* end, const char* name) noexcept
+    {
+        for (auto* node = begin; node != end; node = node->next)
+        {
+            if (std::strcmp(node->name, name) == 0)
+                return node;
+        }
+
+        return nullptr;
+    }
+
+    inline lock_profile_node* acquire_lock_profile_node(const char* name)
+    {
+        lock_profile_epoch();
+
+        auto* head = lock_profile_head.load(std::memory_order_acquire);
+        if (auto* node = find_lock_profile_node(head, nullptr, name))
+            return node;
+
+        auto* node = new lock_profile_node;
+        node->name = name;
+        node->next = head;
+        while (!lock_profile_head.compare_exchange_weak(node->next, node, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            // another thread may have added a node with the same name in the meantime
+            if (auto* existing = find_lock_profile_node(node->next, head, name))
+            {
+                delete node;
+                return existing;
+            }
+
+            head = node->next;
+        }
+
+        return node;
+    }
+
+    inline void update_max(std::atomic<std::uint64_t>& max, std::uint64_t value) noexcept
+    {
+        std::uint64_t current = max.load(std::memory_order_relaxed);
+        while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+            /* retry */;
+    }
+} // namespace impl
+
+// The statistics recorded for all crill::profiled mutexes with the same name.
+struct lock_profile
+{
+    std::string name;
+    // Number of times the lock was acquired.
+    std::uint64_t acquisitions = 0;
+    // Number of times lock() (or a timed try_lock) found the lock taken and had to wait.
+    std::uint64_t contended_acquisitions = 0;
+    // Number of times try_lock() (or a timed try_lock) failed.
+    std::uint64_t failed_try_locks = 0;
+    // Total and maximum time spent waiting in contended acquisitions.
+    std::chrono::nanoseconds total_wait{};
+    std::chrono::nanoseconds max_wait{};
+    // Total time the lock was held.
+    std::chrono::nanoseconds total_hold{};
+};
+
+// crill::profiled wraps a mutex, and records how often it is acquired, how often and
+// how long threads had to wait for it, and how long it was held. This shows which
+// locks in an application are contended. The statistics of all profiled mutexes can
+// be retrieved with crill::get_lock_profiles and crill::write_lock_profile_report.
+//
+// crill::profiled<Mutex> meets the same standard C++ mutex requirements as Mutex
+// (Lockable, or TimedLockable if Mutex has try_lock_for and try_lock_until). Profiling
+// is opt-in, for example with a type alias that depends on a build flag:
+//
+//    #ifdef MY_APP_PROFILE_LOCKS
+//      using app_mutex = crill::profiled<crill::spin_mutex>;
+//    #else
+//      using app_mutex = crill::spin_mutex;
+//    #endif
+//
+// Durations are measured with the CPU's cycle counter (TSC on Intel, CNTVCT_EL0 on
+// ARM), and an uncontended lock() reads it only once, so the overhead is a few
+// dozen cycles per lock()/unlock() pair plus a few atomic additions. The lock
+// and unlock operations of the wrapped mutex keep their non-blocking guarantees.
+//
+// Mutexes are identified by name, which must be given. All mutexes constructed with
+// the same name share one record, which is useful for mutexes that are members of
+// many objects of the same class. Records are never freed, so that the report also covers mutexes
+// that have already been destroyed.
+template <typename Mutex>
+class profiled
+{
+public:
+    // Effects: Constructs the wrapped mutex, and registers it under the given name.
+    // The first mutex with a given name allocates a new record.
+    // Preconditions: name is a null-terminated string that outlives the program,
+    // for example a string literal.
+    explicit profiled(const char* name)
+      : record(impl::acquire_lock_profile_node(name))
+    {
+    }
+
+    profiled(const profiled&) = delete;
+    profiled& operator=(const profiled&) = delete;
+
+    // Effects: Acquires the lock, like Mutex::lock(), and records the wait time if
+    // the lock was not immediately available.
+    void lock()
+    {
+        if (mtx.try_lock())
+        {
+            locked(0);
+            return;
+        }
+
+        const std::uint64_t start = impl::read_cycle_counter();
+        mtx.lock();
+        contended_locked(start);
+    }
+
+    // Effects: Attempts to acquire the lock, like Mutex::try_lock().
+    // Returns: true if the lock was acquired, false otherwise.
+    bool try_lock()
+    {
+        if (mtx.try_lock())
+        {
+            locked(0);
+            return true;
+        }
+
+        record->failed_try_locks.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Effects: Attempts to acquire the lock, like Mutex::try_lock_for().
+    // Returns: true if the lock was acquired, false otherwise.
+    template <typename Rep, typename Period>
+    bool try_lock_for(const std::chrono::duration<Rep, Period>& timeout)
+    {
+        if (mtx.try_lock())
+        {
+            locked(0);
+            return true;
+        }
+
+        const std::uint64_t start = impl::read_cycle_counter();
+        return timed_locked(start, mtx.try_lock_for(timeout));
+    }
+
+    // Effects: Attempts to acquire the lock, like Mutex::try_lock_until().
+    // Returns: true if the lock was acquired, false otherwise.
+    template <typename Clock, typename Duration>
+    bool try_lock_until(const std::chrono::time_point<Clock, Duration>& deadline)
+    {
+        if (mtx.try_lock())
+        {
+            locked(0);
+            return true;
+        }
+
+        const std::uint64_t start = impl::read_cycle_counter();
+        return timed_locked(start, mtx.try_lock_until(deadline));
+    }
+
+    // Effects: Releases the lock, like Mutex::unlock(), and records the hold time.
+    void unlock()
+    {
+        const std::uint64_t hold = impl::read_cycle_counter() - hold_start;
+        mtx.unlock();
+        record->hold_ticks.fetch_add(hold, std::memory_order_relaxed);
+    }
+
+private:
+    void locked(std::uint64_t wait)
+    {
+        // Only read after the lock was acquired, by the thread holding it.
+        hold_start = impl::read_cycle_counter();
+        record->acquisitions.fetch_add(1, std::memory_order_relaxed);
+
+        if (wait != 0)
+        {
+            record->contended_acquisitions.fetch_add(1, std::memory_order_relaxed);
+            record->wait_ticks.fetch_add(wait, std::memory_order_relaxed);
+            impl::update_max(record->max_wait_ticks, wait);
+        }
+    }
+
+    void contended_locked(std::uint64_t start)
+    {
+        // make sure that a contended acquisition is counted even if the counter did
+        // not advance
+        locked(std::max<std::uint64_t>(impl::read_cycle_counter() - start, 1));
+    }
+
+    bool timed_locked(std::uint64_t start, bool success)
+    {
+        if (success)
+        {
+            contended_locked(start);
+            return true;
+        }
+
+        record->failed_try_locks.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Mutex mtx;
+    impl::lock_profile_node* record;
+    std::uint64_t hold_start = 0;
+};
+
+// Returns: the statistics of all crill::profiled mutexes, sorted by the total time
+// that threads spent waiting for them, longest first.
+// Allocates memory, and should therefore not be called on a real-time thread.
+inline std::vector<lock_profile> get_lock_profiles()
+{
+    const double ticks_per_ns = impl::measure_cycle_counter_ticks_per_ns(
+        impl::lock_profile_epoch(), impl::cycle_counter_sample::now());
+
+    auto to_ns = [ticks_per_ns](std::uint64_t ticks) {
+        return std::chrono::nanoseconds(std::int64_t(double(ticks) / ticks_per_ns));
+    };
+
+    std::vector<lock_profile> profiles;
+    for (auto* node = impl::lock_profile_head.load(std::memory_order_acquire); node != nullptr; node = node->next)
+    {
+        lock_profile profile;
+        profile.name = node->name;
+        profile.acquisitions = node->acquisitions.load(std::memory_order_relaxed);
+        profile.contended_acquisitions = node->contended_acquisitions.load(std::memory_order_relaxed);
+        profile.failed_try_locks = node->failed_try_locks.load(std::memory_order_relaxed);
+        profile.total_wait = to_ns(node->wait_ticks.load(std::memory_order_relaxed));
+        profile.max_wait = to_ns(node->max_wait_ticks.load(std::memory_order_relaxed));
+        profile.total_hold = to_ns(node->hold_ticks.load(std::memory_order_relaxed));
+        profiles.push_back(std::move(profile));
+    }
+
+    std::stable_sort(profiles.begin(), profiles.end(), [](const auto& a, const auto& b) {
+        return a.total_wait > b.total_wait;
+    });
+
+    return profiles;
+}
+
+// Effects: Writes a table of the statistics of all crill::profiled mutexes to the
+// given stream, one line per name, sorted like crill::get_lock_profiles. Durations are
+// in microseconds.
+inline void write_lock_profile_report(std::ostream& os)
+{
+    os << "name\tacquisitions\tcontended\tfailed_try_locks\ttotal_wait_us\tmax_wait_us\ttotal_hold_us\n";
+
+    auto us = [](std::chrono::nanoseconds ns) { return double(ns.count()) * 1e-3; };
+    for (const auto& profile : get_lock_profiles())
+    {
+        os << profile.name << '\t'
+           << profile.acquisitions << '\t'
+           << profile.contended_acquisitions << '\t'
+           << profile.failed_try_locks << '\t'
+           << us(profile.total_wait) << '\t'
+           << us(profile.max_wait) << '\t'
+           << us(profile.total_hold) << '\n';
+    }
+}
+
+} // namespace crill
+
+#endif //CRILL_PROFILED_MUTEX_H
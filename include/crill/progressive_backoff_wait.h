@@ -6,7 +6,10 @@
 #ifndef CRILL_PROGRESSIVE_BACKOFF_WAIT_H
 #define CRILL_PROGRESSIVE_BACKOFF_WAIT_H
 
+#include <chrono>
+#include <utility>
 #include <crill/platform.h>
+#include <crill/backoff_policy.h>
 #include <crill/impl/progressive_backoff_wait_impl.h>
 
 namespace crill {
@@ -24,25 +27,165 @@ namespace crill {
 //
 // the progressive backoff strategy prevents wasting energy, and allows other threads
 // to progress by yielding from the waiting thread after a certain amount of time.
-// This time is currently chosen to be approximately 1 ms on a typical 64-bit Intel
-// or ARM based machine.
+// This time is approximately 1 ms by default. Because the cost of a pause
+// instruction varies by more than an order of magnitude between CPUs, the number
+// of iterations spent in each phase is derived at startup from a measurement of
+// that cost (see crill::progressive_backoff_timings below).
+//
+// The backoff strategy can be changed at compile time by passing a different
+// backoff policy as the first template argument; see crill/backoff_policy.h.
 //
 // On platforms other than x86, x86_64, and arm64, no implementation is currently available.
-template <typename Predicate>
+template <typename BackoffPolicy = default_progressive, typename Predicate>
 void progressive_backoff_wait(Predicate&& pred)
 {
-  #if CRILL_INTEL
-    impl::progressive_backoff_wait_intel<5, 10, 3000>(std::forward<Predicate>(pred));
-    // approx. 5x5 ns (= 25 ns), 10x40 ns (= 400 ns), and 3000x350 ns (~ 1 ms),
-    // respectively, when measured on a 2.9 GHz Intel i9
-  #elif CRILL_ARM_64BIT
-    impl::progressive_backoff_wait_armv8<2, 750>(std::forward<Predicate>(pred));
-    // approx. 2x10 ns (= 20 ns) and 750x1333 ns (~ 1 ms), respectively, on an
-    // Apple Silicon Mac or an armv8 based phone.
-  #else
-    #error "Platform not supported!"
-  #endif
+    impl::no_deadline deadline;
+    impl::yield_idle idle;
+    while (!BackoffPolicy::wait(pred, deadline, idle))
+        /* policy gave up, start over */;
+}
+
+// Effects: Blocks the current thread until predicate returns true or until a stop
+// is requested on the given stop token (crill::stop_token, which is std::stop_token
+// in C++20, or any type with a stop_requested() member function).
+// Returns: true if predicate returned true, false if the wait was cancelled.
+//
+// The stop token is checked when the wait starts, and then only at phase boundaries:
+// in place of yielding when the spin budget has been used up (approx. every 1 ms with
+// the default policy), and whenever a bounded policy gives up. The spin loops are
+// therefore as tight as for an untimed wait. crill::realtime_never_yield never
+// reaches a phase boundary, so it never checks the stop token after the wait has
+// started.
+template <typename BackoffPolicy = default_progressive, typename Predicate, typename StopToken,
+          typename = decltype(std::declval<const StopToken&>().stop_requested())>
+bool progressive_backoff_wait(Predicate&& pred, const StopToken& token)
+{
+    if (token.stop_requested())
+        return pred();
+
+    impl::stop_token_deadline<StopToken> deadline(token);
+    while (!BackoffPolicy::wait(pred, deadline, deadline))
+    {
+        // the policy gave up, which is a phase boundary too
+        if (deadline.expired() || token.stop_requested())
+            return false;
+    }
+
+    return true;
+}
+
+// Effects: Like crill::progressive_backoff_wait, but gives up if the backoff policy
+// gives up, instead of starting over.
+// Returns: true if predicate returned true, false if the policy gave up first.
+//
+// This is useful with a bounded policy such as crill::realtime_bounded, to wait on
+// a real-time thread for a deterministic amount of time without ever yielding:
+//
+//    if (crill::progressive_backoff_try_wait<crill::realtime_bounded<>>([&]{ return mtx.try_lock(); }))
+//        /* locked */;
+//    else
+//        /* fall back */;
+//
+// With policies that never give up, this always returns true.
+template <typename BackoffPolicy = default_progressive, typename Predicate>
+bool progressive_backoff_try_wait(Predicate&& pred)
+{
+    impl::no_deadline deadline;
+    impl::yield_idle idle;
+    return BackoffPolicy::wait(pred, deadline, idle);
+}
+
+// Effects: Blocks the current thread until predicate returns true or until the
+// given timeout has elapsed, using the same progressive backoff strategy as
+// crill::progressive_backoff_wait.
+// Returns: true if predicate returned true, false if the timeout elapsed first.
+//
+// The deadline is checked against the CPU's cycle counter (TSC on Intel, CNTVCT_EL0
+// on ARM) once per block of pauses, so the spin phases are no slower than for an
+// untimed wait. The wait may return up to one block of pauses after the deadline
+// (typically well below 1 us on Intel; on ARM this depends on the wfe wakeup
+// frequency), or later if the thread is preempted. It never returns false before
+// the timeout has elapsed.
+template <typename BackoffPolicy = default_progressive, typename Predicate, typename Rep, typename Period>
+bool progressive_backoff_wait_for(Predicate&& pred, const std::chrono::duration<Rep, Period>& timeout)
+{
+    impl::cycle_counter_deadline deadline(impl::steady_deadline_after(timeout));
+    impl::yield_idle idle;
+    return BackoffPolicy::wait(pred, deadline, idle);
+}
+
+// Effects: Blocks the current thread until predicate returns true or until the
+// given point in time has been reached. See crill::progressive_backoff_wait_for.
+// Returns: true if predicate returned true, false if the deadline was reached first.
+template <typename BackoffPolicy = default_progressive, typename Predicate, typename Clock, typename Duration>
+bool progressive_backoff_wait_until(Predicate&& pred, const std::chrono::time_point<Clock, Duration>& deadline)
+{
+    impl::cycle_counter_deadline cycle_deadline(impl::steady_deadline_after(deadline - Clock::now()));
+    impl::yield_idle idle;
+    return BackoffPolicy::wait(pred, cycle_deadline, idle);
+}
+
+// The timings used by crill::progressive_backoff_wait.
+struct progressive_backoff_timings
+{
+    // The duration of a single pause instruction (Intel) or wfe instruction (ARM).
+    std::chrono::duration<double, std::nano> pause_duration;
+
+    // How long to spin with a single pause per iteration before moving on to the
+    // last phase. Only used on Intel.
+    std::chrono::nanoseconds pause_phase;
+
+    // How long to spin in the last phase before each call to std::this_thread::yield.
+    std::chrono::nanoseconds yield_interval;
+};
+
+// Returns: the timings currently used by crill::progressive_backoff_wait.
+inline progressive_backoff_timings get_progressive_backoff_timings() noexcept
+{
+    return {
+        std::chrono::duration<double, std::nano>(impl::backoff_state.pause_ns.load(std::memory_order_relaxed)),
+        std::chrono::nanoseconds(impl::backoff_state.pause_phase_ns.load(std::memory_order_relaxed)),
+        std::chrono::nanoseconds(impl::backoff_state.yield_interval_ns.load(std::memory_order_relaxed))
+    };
+}
+
+// Effects: Overrides the timings used by crill::progressive_backoff_wait. The
+// number of iterations for each phase is derived from the given pause duration.
+// Calls to crill::progressive_backoff_wait that have already started are not affected.
+inline void set_progressive_backoff_timings(const progressive_backoff_timings& timings) noexcept
+{
+    impl::set_progressive_backoff_state(
+        timings.pause_duration.count(),
+        timings.pause_phase.count(),
+        timings.yield_interval.count());
+}
+
+// Effects: Measures the duration of a pause (Intel) or wfe (ARM) instruction on the
+// current machine and updates the timings used by crill::progressive_backoff_wait
+// accordingly, keeping the current phase durations. Also measures the frequency of
+// the cycle counter used for the deadlines of crill::progressive_backoff_wait_for.
+// Returns: the updated timings.
+//
+// This is done automatically at static initialisation time, which takes on the
+// order of 100 us. To skip it, define CRILL_NO_STARTUP_CALIBRATION; the iteration
+// counts then stay at values that were measured on a 2.9 GHz Intel i9 and on
+// Apple Silicon, respectively, until this function is called.
+inline progressive_backoff_timings calibrate_progressive_backoff() noexcept
+{
+    auto timings = get_progressive_backoff_timings();
+    auto start = impl::cycle_counter_sample::now();
+    timings.pause_duration = std::chrono::duration<double, std::nano>(impl::measure_backoff_pause_ns());
+    impl::calibrate_cycle_counter(start, impl::cycle_counter_sample::now());
+    set_progressive_backoff_timings(timings);
+    return timings;
+}
+
+#ifndef CRILL_NO_STARTUP_CALIBRATION
+namespace impl
+{
+    inline const bool progressive_backoff_calibrated_at_startup = (calibrate_progressive_backoff(), true);
 }
+#endif
 
 } // namespace crill
 
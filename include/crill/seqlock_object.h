@@ -8,17 +8,41 @@
 
 #include <cstring>
 #include <atomic>
+#include <crill/progressive_backoff_wait.h>
 
 namespace crill {
 
+// Whether a crill::seqlock_object may be written by one thread at a time or by
+// multiple threads concurrently.
+enum class seqlock_writers
+{
+    single,
+    multiple
+};
+
 // A portable C++ implementation of a seqlock inspired by Hans Boehm's paper
 // "Can Seqlocks Get Along With Programming Language Memory Models?"
 // and the C implementation in jemalloc.
 //
-// This version allows only a single writer. Writes are guaranteed wait-free.
+// By default, this allows only a single writer. Writes are guaranteed wait-free.
 // It also allows multiple concurrent readers, which are wait-free against
 // each other, but can block if there is a concurrent write.
-template <typename T>
+//
+// With Writers = seqlock_writers::multiple (or crill::multi_writer_seqlock_object),
+// store() may also be called by multiple threads concurrently. A writer then claims
+// the odd sequence number with a compare-exchange on the sequence counter itself
+// instead of a plain store, and waits with crill::progressive_backoff_wait if another
+// writer has already claimed it. This avoids protecting store() with a separate mutex
+// and touching a second cache line. Writes are no longer wait-free, but the cost of
+// reading is the same as with a single writer.
+//
+// load() waits for a concurrent write to finish with crill::progressive_backoff_wait,
+// using the given backoff policy (see crill/backoff_policy.h).
+//
+// seqlock_object is address-free: it can be placed in memory shared between
+// processes, for example with crill::shared_memory_object, so that a process can
+// read values written by another one without any system calls.
+template <typename T, typename BackoffPolicy = default_progressive, seqlock_writers Writers = seqlock_writers::single>
 class seqlock_object
 {
 public:
@@ -42,7 +66,7 @@ public:
     T load() const noexcept
     {
         T t;
-        while (!try_load(t)) /* keep trying */;
+        progressive_backoff_wait<BackoffPolicy>([&]{ return try_load(t); });
         return t;
     }
 
@@ -71,7 +95,7 @@ public:
     }
 
     // Updates the current value to the value passed in.
-    // Non-blocking guarantees: wait-free.
+    // Non-blocking guarantees: wait-free with a single writer, otherwise none.
     void store(T t) noexcept
     {
         std::size_t buffer[buffer_size];
@@ -81,7 +105,27 @@ public:
         std::memcpy(&buffer, &t, sizeof(T));
 
         std::size_t old_seq = seq.load(std::memory_order_relaxed);
-        seq.store(old_seq + 1, std::memory_order_relaxed);
+        if constexpr (Writers == seqlock_writers::single)
+        {
+            seq.store(old_seq + 1, std::memory_order_relaxed);
+        }
+        else
+        {
+            // acquire pairs with the release store that completes the previous write,
+            // so that our data stores are ordered after that writer's
+            auto try_claim = [&]{
+                return old_seq % 2 == 0 && seq.compare_exchange_weak(
+                    old_seq, old_seq + 1, std::memory_order_acquire, std::memory_order_relaxed);
+            };
+
+            if (!try_claim())
+            {
+                progressive_backoff_wait<BackoffPolicy>([&]{
+                    old_seq = seq.load(std::memory_order_relaxed);
+                    return try_claim();
+                });
+            }
+        }
 
         std::atomic_thread_fence(std::memory_order_release);
 
@@ -99,6 +143,9 @@ private:
     static_assert(decltype(seq)::is_always_lock_free);
 };
 
+template <typename T, typename BackoffPolicy = default_progressive>
+using multi_writer_seqlock_object = seqlock_object<T, BackoffPolicy, seqlock_writers::multiple>;
+
 } // namespace crill
 
 #endif //CRILL_SEQLOCK_OBJECT_H
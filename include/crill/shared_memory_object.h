@@ -0,0 +1,383 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#ifndef CRILL_SHARED_MEMORY_OBJECT_H
+#define CRILL_SHARED_MEMORY_OBJECT_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <crill/progressive_backoff_wait.h>
+
+#if defined(_WIN32)
+  // Declared here rather than including <windows.h>, see crill/impl/futex.h.
+  struct _SECURITY_ATTRIBUTES;
+  extern "C" __declspec(dllimport) void* __stdcall CreateFileMappingA(void*, _SECURITY_ATTRIBUTES*, unsigned long, unsigned long, unsigned long, const char*);
+  #if defined(_WIN64)
+  extern "C" __declspec(dllimport) void* __stdcall MapViewOfFile(void*, unsigned long, unsigned long, unsigned long, unsigned __int64);
+  #else
+  extern "C" __declspec(dllimport) void* __stdcall MapViewOfFile(void*, unsigned long, unsigned long, unsigned long, unsigned long);
+  #endif
+  extern "C" __declspec(dllimport) int __stdcall UnmapViewOfFile(const void*);
+  extern "C" __declspec(dllimport) int __stdcall CloseHandle(void*);
+  extern "C" __declspec(dllimport) unsigned long __stdcall GetLastError();
+#else
+  #include <cerrno>
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace crill
+{
+namespace impl
+{
+    // Incremented whenever the layout of a crill type that may be placed in shared
+    // memory changes, so that processes built against different versions of crill
+    // refuse to share it.
+    inline constexpr std::uint32_t shared_layout_version = 1;
+
+    inline constexpr std::uint32_t shared_region_magic = 0x6C697263; // "cril"
+
+  #if defined(_WIN32)
+    // The values of the <windows.h> constants used by crill::shared_memory_object.
+    inline void* const win32_invalid_handle_value = reinterpret_cast<void*>(std::intptr_t(-1));
+    inline constexpr unsigned long win32_page_readwrite = 0x04;
+    inline constexpr unsigned long win32_file_map_all_access = 0xF001F;
+    inline constexpr unsigned long win32_error_already_exists = 183;
+  #endif
+
+    // Placed at the start of every shared memory region, before the object. magic and
+    // layout_version must stay at offsets 0 and 4 in every version of crill, so that
+    // processes can always tell whether they agree on the rest of the layout. The
+    // creator stores magic last, with release semantics, once the other fields of the
+    // header are written, and state once the object has been constructed.
+    struct shared_region_header
+    {
+        std::atomic<std::uint32_t> magic;
+        std::uint32_t layout_version;
+        std::uint64_t layout_hash;
+        std::atomic<std::uint32_t> state;
+    };
+
+    enum : std::uint32_t { shared_region_uninitialised, shared_region_ready };
+
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+
+    // Returns: a hash of the properties of the build that affect the layout of T, and
+    // of the user-supplied version.
+    template <typename T>
+    constexpr std::uint64_t shared_layout_hash(std::uint32_t user_version) noexcept
+    {
+        std::uint64_t h = 14695981039346656037ull; // FNV-1a
+        for (std::uint64_t value : { std::uint64_t(sizeof(T)), std::uint64_t(alignof(T)),
+                                     std::uint64_t(sizeof(void*)), std::uint64_t(user_version) })
+        {
+            for (int i = 0; i < 8; ++i)
+            {
+                h ^= (value >> (8 * i)) & 0xFF;
+                h *= 1099511628211ull;
+            }
+        }
+
+        return h;
+    }
+} // namespace impl
+
+// crill::shared_memory_object<T> creates, or attaches to, a named region of shared
+// memory containing an object of type T, so that crill::spin_mutex and
+// crill::seqlock_object can synchronise threads in different processes, for example
+// a real-time engine and the process running its GUI:
+//
+//    struct shared_state
+//    {
+//        crill::seqlock_object<parameters> params;
+//        crill::spin_mutex preset_mutex;
+//        preset current_preset;
+//    };
+//
+//    crill::shared_memory_object<shared_state> state("/my_app_state");
+//    state->params.store(new_params);                  // in one process
+//    auto params = state->params.load();               // in another process
+//
+// Once the region is mapped, accessing the object involves no system calls.
+//
+// T must be a standard-layout type that is address-free: it must work when mapped
+// at different addresses in different processes, so it must not contain pointers or
+// references, or anything else that is only meaningful within one process.
+// crill::spin_mutex (with the default or any other backoff policy from
+// crill/backoff_policy.h) and crill::seqlock_object are address-free: their state
+// consists only of lock-free atomic integers, whose operations work on the memory
+// location regardless of the address it is mapped at [atomics.lockfree]. Mutexes that
+// can put threads to sleep (crill::hybrid_mutex, crill::parking_spot) use
+// process-private futexes and are not address-free. Neither is crill::spin_mutex if
+// CRILL_CHECK_MUTEX_OWNERSHIP is defined, since thread ids are per-process.
+//
+// The region starts with a header holding a hash of the size and alignment of T, the
+// pointer size, a version of crill's layout, and the user_version passed to the
+// constructor. Attaching to a region whose header does not match throws immediately,
+// before waiting for the object, so that processes built differently cannot corrupt
+// each other's state; increment user_version whenever T changes.
+//
+// The first process to open a name creates the region and constructs the object with
+// the given arguments. Other processes wait for the construction to finish. The
+// object is never destroyed, and the region lives until remove() is called (on
+// Windows, until the last process has closed it).
+template <typename T>
+class shared_memory_object
+{
+public:
+    static_assert(std::is_standard_layout_v<T>);
+
+    // Effects: Opens the shared memory region with the given name, creating it and
+    // constructing a T from args if it does not exist yet.
+    // Throws: std::system_error if the region could not be created, opened, or mapped;
+    // std::runtime_error if the region was created with a different layout hash (see
+    // above), or if its creator did not finish constructing the object within
+    // the timeout. If the constructor of T throws, the region is unmapped and
+    // removed, and the exception is propagated.
+    // On POSIX systems, the name should start with a slash and contain no further
+    // slashes.
+    template <typename... Args>
+    explicit shared_memory_object(const char* name, std::uint32_t user_version = 0, Args&&... args)
+    {
+        open(name);
+
+        if (is_creator)
+        {
+            auto* header = new (address) impl::shared_region_header;
+            header->layout_version = impl::shared_layout_version;
+            header->layout_hash = impl::shared_layout_hash<T>(user_version);
+            header->state.store(impl::shared_region_uninitialised, std::memory_order_relaxed);
+            header->magic.store(impl::shared_region_magic, std::memory_order_release);
+
+            try
+            {
+                new (object_address()) T(std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                close();
+                remove(name);
+                throw;
+            }
+
+            header->state.store(impl::shared_region_ready, std::memory_order_release);
+            return;
+        }
+
+        // The header was constructed by the creator, possibly in another process;
+        // constructing it again here would overwrite its state.
+        auto* header = std::launder(reinterpret_cast<impl::shared_region_header*>(address));
+
+        // Only state depends on the layout of the header being the same, so it is
+        // read only once the rest of the header has been checked.
+        std::uint32_t magic = 0;
+        if (!progressive_backoff_wait_for([&]{
+                magic = header->magic.load(std::memory_order_acquire);
+                return magic != 0;
+            }, timeout))
+        {
+            close();
+            throw not_initialised(name);
+        }
+
+        if (magic != impl::shared_region_magic
+            || header->layout_version != impl::shared_layout_version
+            || header->layout_hash != impl::shared_layout_hash<T>(user_version))
+        {
+            close();
+            throw different_layout(name);
+        }
+
+        if (!progressive_backoff_wait_for([&]{
+                return header->state.load(std::memory_order_acquire) == impl::shared_region_ready;
+            }, timeout))
+        {
+            close();
+            throw not_initialised(name);
+        }
+    }
+
+    // Effects: Unmaps the region. Does not destroy the object or remove the region.
+    ~shared_memory_object()
+    {
+        close();
+    }
+
+    shared_memory_object(const shared_memory_object&) = delete;
+    shared_memory_object& operator=(const shared_memory_object&) = delete;
+
+    // Returns: the object in shared memory.
+    T& get() const noexcept
+    {
+        return *std::launder(static_cast<T*>(object_address()));
+    }
+
+    T& operator*() const noexcept { return get(); }
+    T* operator->() const noexcept { return &get(); }
+
+    // Returns: true if this process created the region and constructed the object.
+    bool created() const noexcept
+    {
+        return is_creator;
+    }
+
+    // Effects: Removes the name of the shared memory region, so that the next process
+    // opening it creates a new one. Processes that have it mapped keep using the old
+    // region. Does nothing on Windows, where regions are removed automatically.
+    // Returns: true if the region existed and was removed.
+    static bool remove(const char* name) noexcept
+    {
+      #if defined(_WIN32)
+        (void)name;
+        return false;
+      #else
+        return shm_unlink(name) == 0;
+      #endif
+    }
+
+private:
+    static constexpr std::size_t object_offset()
+    {
+        constexpr std::size_t align = alignof(T) > alignof(impl::shared_region_header)
+            ? alignof(T) : alignof(impl::shared_region_header);
+        return (sizeof(impl::shared_region_header) + align - 1) / align * align;
+    }
+
+    static constexpr std::size_t region_size = object_offset() + sizeof(T);
+    static constexpr std::chrono::seconds timeout = std::chrono::seconds(5);
+
+    void* object_address() const noexcept
+    {
+        return static_cast<char*>(address) + object_offset();
+    }
+
+    static std::runtime_error not_initialised(const char* name)
+    {
+        return std::runtime_error(std::string("shared memory region not initialised: ") + name);
+    }
+
+    static std::runtime_error different_layout(const char* name)
+    {
+        return std::runtime_error(std::string("shared memory region has a different layout: ") + name);
+    }
+
+  #if defined(_WIN32)
+    void open(const char* name)
+    {
+        handle = CreateFileMappingA(impl::win32_invalid_handle_value, nullptr, impl::win32_page_readwrite,
+                                    0, static_cast<unsigned long>(region_size), name);
+        if (handle == nullptr)
+            throw std::system_error(int(GetLastError()), std::system_category(), "CreateFileMapping");
+
+        is_creator = GetLastError() != impl::win32_error_already_exists;
+
+        // An existing region is mapped in full (size 0), so that the header can be
+        // checked even if the region is smaller than this build's region_size.
+        address = MapViewOfFile(handle, impl::win32_file_map_all_access, 0, 0, is_creator ? region_size : 0);
+        if (address == nullptr)
+        {
+            auto error = int(GetLastError());
+            CloseHandle(handle);
+            throw std::system_error(error, std::system_category(), "MapViewOfFile");
+        }
+    }
+
+    void close() noexcept
+    {
+        if (address != nullptr)
+            UnmapViewOfFile(address);
+
+        if (handle != nullptr)
+            CloseHandle(handle);
+
+        address = nullptr;
+        handle = nullptr;
+    }
+
+    void* handle = nullptr;
+  #else
+    void open(const char* name)
+    {
+        int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        is_creator = fd >= 0;
+
+        if (is_creator)
+        {
+            if (ftruncate(fd, off_t(region_size)) != 0)
+                fail(fd, name, "ftruncate");
+        }
+        else
+        {
+            if (errno != EEXIST || (fd = shm_open(name, O_RDWR, 0600)) < 0)
+                throw std::system_error(errno, std::generic_category(), "shm_open");
+
+            // The creator may not have set the size yet, and mapping beyond the end of
+            // the file would crash on access. Once set, the size does not change.
+            struct stat st{};
+            if (!progressive_backoff_wait_for([&]{
+                    return fstat(fd, &st) != 0 || st.st_size != 0;
+                }, timeout))
+            {
+                ::close(fd);
+                throw not_initialised(name);
+            }
+
+            if (st.st_size == 0)
+                fail(fd, name, "fstat");
+
+            // The layout hash covers the size of T, so a smaller region was created
+            // with a different layout.
+            if (std::size_t(st.st_size) < region_size)
+            {
+                ::close(fd);
+                throw different_layout(name);
+            }
+        }
+
+        address = mmap(nullptr, region_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED)
+        {
+            address = nullptr;
+            fail(fd, name, "mmap");
+        }
+
+        ::close(fd);
+    }
+
+    [[noreturn]] void fail(int fd, const char* name, const char* what)
+    {
+        int error = errno;
+        ::close(fd);
+        if (is_creator)
+            shm_unlink(name);
+
+        throw std::system_error(error, std::generic_category(), what);
+    }
+
+    void close() noexcept
+    {
+        if (address != nullptr)
+            munmap(address, region_size);
+
+        address = nullptr;
+    }
+  #endif
+
+    void* address = nullptr;
+    bool is_creator = false;
+};
+
+} // namespace crill
+
+#endif //CRILL_SHARED_MEMORY_OBJECT_H
@@ -7,8 +7,17 @@
 #define CRILL_SPIN_MUTEX_H
 
 #include <atomic>
+#include <chrono>
 #include <mutex>
+#include <type_traits>
 #include <crill/progressive_backoff_wait.h>
+#include <crill/wait_for_change.h>
+
+#ifdef CRILL_CHECK_MUTEX_OWNERSHIP
+  #include <cstdio>
+  #include <cstdlib>
+  #include <thread>
+#endif
 
 namespace crill
 {
@@ -16,28 +25,75 @@ namespace crill
 // crill::spin_mutex is a spinlock with progressive backoff for safely and
 // efficiently synchronising a real-time thread with other threads.
 //
-// crill::spin_mutex meets the standard C++ requirements for mutex
-// [thread.req.lockable.req] and can therefore be used with std::scoped_lock
-// and std::unique_lock as a drop-in replacement for std::mutex.
+// crill::spin_mutex meets the standard C++ requirements for timed mutex
+// [thread.timedmutex.requirements] and can therefore be used with std::scoped_lock
+// and std::unique_lock (including its timed constructors) as a drop-in replacement
+// for std::mutex or std::timed_mutex.
 //
-// try_lock() and unlock() are implemented by setting a std::atomic_flag and
+// try_lock() and unlock() are implemented by setting a std::atomic<bool> and
 // are therefore always wait-free. This is the main difference to a std::mutex
 // which doesn't have a wait-free unlock() as std::mutex::unlock() may perform
 // a system call to wake up a waiting thread.
 //
 // lock() is implemented with crill::progressive_backoff_wait, to prevent wasting
-// energy and allow other threads to progress.
+// energy and allow other threads to progress. While waiting, it polls the lock with
+// plain loads and only attempts to acquire it when it looks free
+// (test-and-test-and-set). This way, waiting threads share the cache line holding
+// the lock instead of bouncing it between their cores with atomic RMW operations,
+// which would also slow down the thread releasing the lock. On arm64, it waits with
+// crill::wait_for_change instead, which wakes up as soon as the lock is released.
 //
 // crill::spin_mutex is not recursive; repeatedly locking it on the same thread
 // is undefined behaviour (in practice, it will probably deadlock your app).
-class spin_mutex
+//
+// crill::spin_mutex is address-free: it can be placed in memory shared between
+// processes, for example with crill::shared_memory_object.
+//
+// If CRILL_CHECK_MUTEX_OWNERSHIP is defined, crill::spin_mutex additionally records
+// the id of the thread holding the lock, and aborts the program with a message if
+// lock(), try_lock_for() or try_lock_until() is called by the thread already holding
+// the lock, if unlock() is called by a thread not holding it, or if it is destroyed
+// while locked. This is meant for debug builds: the checks make the mutex larger,
+// and unlock() is no longer a single store. The macro must be defined the same way in
+// all translation units. Without it, crill::spin_mutex is a single std::atomic<bool>.
+//
+// crill::spin_mutex is an alias for crill::basic_spin_mutex with the default backoff
+// policy. Use crill::basic_spin_mutex directly to choose a different policy from
+// crill/backoff_policy.h.
+template <typename BackoffPolicy = default_progressive>
+class basic_spin_mutex
 {
 public:
+  #ifdef CRILL_CHECK_MUTEX_OWNERSHIP
+    ~basic_spin_mutex()
+    {
+        if (flag.load(std::memory_order_relaxed))
+            ownership_violation("crill::spin_mutex destroyed while locked");
+    }
+  #endif
+
     // Effects: Acquires the lock. If necessary, blocks until the lock can be acquired.
     // Preconditions: The current thread does not already hold the lock.
     void lock() noexcept
     {
-        progressive_backoff_wait([this]{ return try_lock(); });
+        check_not_owner();
+
+      #if CRILL_ARM_64BIT
+        if constexpr (std::is_same_v<BackoffPolicy, default_progressive>)
+        {
+            while (!try_lock())
+                wait_for_change(flag, true);
+
+            return;
+        }
+      #endif
+
+        if (try_lock())
+            return;
+
+        progressive_backoff_wait<BackoffPolicy>([this]{
+            return !flag.load(std::memory_order_relaxed) && try_lock();
+        });
     }
 
     // Effects: Attempts to acquire the lock without blocking.
@@ -45,7 +101,45 @@ public:
     // Non-blocking guarantees: wait-free.
     bool try_lock() noexcept
     {
-        return !flag.test_and_set(std::memory_order_acquire);
+        if (flag.exchange(true, std::memory_order_acquire))
+            return false;
+
+      #ifdef CRILL_CHECK_MUTEX_OWNERSHIP
+        owner.store(std::this_thread::get_id(), std::memory_order_relaxed);
+      #endif
+        return true;
+    }
+
+    // Effects: Attempts to acquire the lock, blocking for at most the given timeout.
+    // Returns: true if the lock was acquired, false otherwise.
+    // Preconditions: The current thread does not already hold the lock.
+    //
+    // This waits with crill::progressive_backoff_wait_for, so it may return slightly
+    // after the timeout (see there), but never fails before it has elapsed. This
+    // allows a real-time thread to try for a short time, and fall back to something
+    // else if the lock could not be acquired:
+    //
+    //    std::unique_lock lock(mtx, std::chrono::microseconds(20));
+    //    if (!lock.owns_lock())
+    //        /* fall back */;
+    template <typename Rep, typename Period>
+    bool try_lock_for(const std::chrono::duration<Rep, Period>& timeout) noexcept
+    {
+        check_not_owner();
+        return try_lock() || progressive_backoff_wait_for<BackoffPolicy>(
+            [this]{ return !flag.load(std::memory_order_relaxed) && try_lock(); }, timeout);
+    }
+
+    // Effects: Attempts to acquire the lock, blocking until at most the given point in
+    // time. See try_lock_for.
+    // Returns: true if the lock was acquired, false otherwise.
+    // Preconditions: The current thread does not already hold the lock.
+    template <typename Clock, typename Duration>
+    bool try_lock_until(const std::chrono::time_point<Clock, Duration>& deadline) noexcept
+    {
+        check_not_owner();
+        return try_lock() || progressive_backoff_wait_until<BackoffPolicy>(
+            [this]{ return !flag.load(std::memory_order_relaxed) && try_lock(); }, deadline);
     }
 
     // Effects: Releases the lock.
@@ -53,13 +147,43 @@ public:
     // Non-blocking guarantees: wait-free.
     void unlock() noexcept
     {
-        flag.clear(std::memory_order_release);
+      #ifdef CRILL_CHECK_MUTEX_OWNERSHIP
+        if (owner.load(std::memory_order_relaxed) != std::this_thread::get_id())
+            ownership_violation("crill::spin_mutex unlocked by a thread that does not hold it");
+
+        owner.store(std::thread::id(), std::memory_order_relaxed);
+      #endif
+
+        flag.store(false, std::memory_order_release);
     }
 
 private:
-    std::atomic_flag flag = ATOMIC_FLAG_INIT;
+    void check_not_owner() noexcept
+    {
+      #ifdef CRILL_CHECK_MUTEX_OWNERSHIP
+        if (owner.load(std::memory_order_relaxed) == std::this_thread::get_id())
+            ownership_violation("crill::spin_mutex locked recursively");
+      #endif
+    }
+
+  #ifdef CRILL_CHECK_MUTEX_OWNERSHIP
+    [[noreturn]] static void ownership_violation(const char* message) noexcept
+    {
+        std::fprintf(stderr, "%s\n", message);
+        std::abort();
+    }
+
+    // Only ever equal to the id of the current thread if the current thread holds the
+    // lock, so relaxed accesses are sufficient.
+    std::atomic<std::thread::id> owner = std::thread::id();
+  #endif
+
+    std::atomic<bool> flag = false;
+    static_assert(decltype(flag)::is_always_lock_free);
 };
 
+using spin_mutex = basic_spin_mutex<>;
+
 } // namespace crill
 
 #endif //CRILL_SPIN_MUTEX_H
@@ -0,0 +1,138 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#ifndef CRILL_SPIN_SHARED_MUTEX_H
+#define CRILL_SPIN_SHARED_MUTEX_H
+
+#include <atomic>
+#include <cstdint>
+#include <crill/progressive_backoff_wait.h>
+
+namespace crill
+{
+
+// crill::spin_shared_mutex is a reader-writer spinlock with progressive backoff.
+// Any number of threads can hold it in shared mode at the same time, or one thread
+// in exclusive mode.
+//
+// crill::spin_shared_mutex meets the standard C++ requirements for shared mutex
+// [thread.sharedmutex.requirements] and can therefore be used with std::shared_lock,
+// std::scoped_lock and std::unique_lock as a drop-in replacement for
+// std::shared_mutex.
+//
+// The lock is a single std::atomic<std::uint32_t> holding a flag for the exclusive
+// owner, the number of threads waiting for exclusive ownership, and the number of
+// threads holding shared ownership. try_lock(), try_lock_shared(), unlock() and
+// unlock_shared() are a single atomic operation each and therefore wait-free.
+//
+// Writers are preferred: while a thread is waiting in lock(), new readers are
+// turned away, so that a steady stream of readers cannot starve writers. Readers
+// that already hold the lock are not affected.
+//
+// lock() and lock_shared() are implemented with crill::progressive_backoff_wait, and
+// poll the lock with plain loads until it looks available.
+//
+// Readers all modify the same cache line, so the cost of lock_shared() grows with the
+// number of cores reading concurrently. For data that is read very frequently on many
+// cores and written rarely, see crill::distributed_shared_mutex.
+//
+// crill::spin_shared_mutex is an alias for crill::basic_spin_shared_mutex with the
+// default backoff policy. Use crill::basic_spin_shared_mutex directly to choose a
+// different policy from crill/backoff_policy.h.
+template <typename BackoffPolicy = default_progressive>
+class basic_spin_shared_mutex
+{
+public:
+    // Effects: Acquires exclusive ownership. If necessary, blocks until no other thread
+    // holds the lock.
+    // Preconditions: The current thread does not already hold the lock.
+    void lock() noexcept
+    {
+        if (try_lock())
+            return;
+
+        state.fetch_add(waiting_writer, std::memory_order_relaxed);
+        progressive_backoff_wait<BackoffPolicy>([this]{
+            std::uint32_t s = state.load(std::memory_order_relaxed);
+            if ((s & (writer | reader_mask)) != 0)
+                return false;
+
+            return state.compare_exchange_strong(
+                s, s - waiting_writer + writer, std::memory_order_acquire, std::memory_order_relaxed);
+        });
+    }
+
+    // Effects: Attempts to acquire exclusive ownership without blocking. Fails if any
+    // thread holds or is waiting for the lock.
+    // Returns: true if the lock was acquired, false otherwise.
+    // Non-blocking guarantees: wait-free.
+    bool try_lock() noexcept
+    {
+        std::uint32_t expected = 0;
+        return state.compare_exchange_strong(expected, writer, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    // Effects: Releases exclusive ownership.
+    // Preconditions: The current thread holds exclusive ownership.
+    // Non-blocking guarantees: wait-free.
+    void unlock() noexcept
+    {
+        state.fetch_sub(writer, std::memory_order_release);
+    }
+
+    // Effects: Acquires shared ownership. If necessary, blocks until no thread holds
+    // or is waiting for exclusive ownership.
+    // Preconditions: The current thread does not already hold the lock.
+    void lock_shared() noexcept
+    {
+        if (try_lock_shared())
+            return;
+
+        progressive_backoff_wait<BackoffPolicy>([this]{
+            return (state.load(std::memory_order_relaxed) & (writer | waiting_writer_mask)) == 0
+                && try_lock_shared();
+        });
+    }
+
+    // Effects: Attempts to acquire shared ownership without blocking. Fails if a
+    // thread holds or is waiting for exclusive ownership.
+    // Returns: true if the lock was acquired, false otherwise.
+    // Non-blocking guarantees: wait-free.
+    bool try_lock_shared() noexcept
+    {
+        // Optimistically register as a reader. A writer waits until the reader count is
+        // zero, so backing out again if the lock is not available is harmless.
+        if ((state.fetch_add(1, std::memory_order_acquire) & (writer | waiting_writer_mask)) == 0)
+            return true;
+
+        state.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Effects: Releases shared ownership.
+    // Preconditions: The current thread holds shared ownership.
+    // Non-blocking guarantees: wait-free.
+    void unlock_shared() noexcept
+    {
+        state.fetch_sub(1, std::memory_order_release);
+    }
+
+private:
+    // Bits 0 - 19: number of readers; bits 20 - 30: number of waiting writers;
+    // bit 31: a writer holds the lock.
+    static constexpr std::uint32_t reader_mask = (1u << 20) - 1;
+    static constexpr std::uint32_t waiting_writer = 1u << 20;
+    static constexpr std::uint32_t waiting_writer_mask = ((1u << 31) - 1) & ~reader_mask;
+    static constexpr std::uint32_t writer = 1u << 31;
+
+    std::atomic<std::uint32_t> state = 0;
+    static_assert(decltype(state)::is_always_lock_free);
+};
+
+using spin_shared_mutex = basic_spin_shared_mutex<>;
+
+} // namespace crill
+
+#endif //CRILL_SPIN_SHARED_MUTEX_H
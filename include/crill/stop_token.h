@@ -0,0 +1,100 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#ifndef CRILL_STOP_TOKEN_H
+#define CRILL_STOP_TOKEN_H
+
+#if __cplusplus >= 202002L && defined(__has_include)
+  #if __has_include(<stop_token>)
+    #include <stop_token>
+  #endif
+#endif
+
+#if defined(__cpp_lib_jthread)
+namespace crill {
+
+// In C++20, crill::stop_source and crill::stop_token are std::stop_source and
+// std::stop_token.
+using std::stop_source;
+using std::stop_token;
+
+} // namespace crill
+#else
+
+#include <atomic>
+#include <memory>
+
+namespace crill {
+
+// A minimal equivalent of std::stop_token for C++17: it only supports querying
+// whether a stop has been requested, not registering stop callbacks.
+class stop_token
+{
+public:
+    // Creates a stop_token that has no associated stop_source.
+    stop_token() noexcept = default;
+
+    // Returns: true if a stop has been requested on the associated stop_source.
+    // Non-blocking guarantees: wait-free.
+    bool stop_requested() const noexcept
+    {
+        return state != nullptr && state->load(std::memory_order_acquire);
+    }
+
+    // Returns: true if the stop_token has an associated stop_source.
+    bool stop_possible() const noexcept
+    {
+        return state != nullptr;
+    }
+
+private:
+    friend class stop_source;
+
+    explicit stop_token(std::shared_ptr<std::atomic<bool>> state) noexcept
+      : state(std::move(state))
+    {
+    }
+
+    std::shared_ptr<std::atomic<bool>> state;
+};
+
+// A minimal equivalent of std::stop_source for C++17.
+class stop_source
+{
+public:
+    stop_source()
+      : state(std::make_shared<std::atomic<bool>>(false))
+    {
+    }
+
+    // Returns: a stop_token associated with this stop_source.
+    stop_token get_token() const noexcept
+    {
+        return stop_token(state);
+    }
+
+    // Effects: Requests all associated stop_tokens to stop.
+    // Returns: true if this call made the stop request, false if a stop had
+    // already been requested.
+    // Non-blocking guarantees: wait-free.
+    bool request_stop() noexcept
+    {
+        return !state->exchange(true, std::memory_order_release);
+    }
+
+    // Returns: true if a stop has been requested.
+    bool stop_requested() const noexcept
+    {
+        return state->load(std::memory_order_acquire);
+    }
+
+private:
+    std::shared_ptr<std::atomic<bool>> state;
+};
+
+} // namespace crill
+#endif
+
+#endif //CRILL_STOP_TOKEN_H
@@ -0,0 +1,156 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#ifndef CRILL_STRIPED_LOCK_H
+#define CRILL_STRIPED_LOCK_H
+
+#include <bitset>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <crill/platform.h>
+
+namespace crill
+{
+
+// crill::striped_lock is a fixed-size table of N mutexes of type Mutex, for locking
+// the state of many objects with fewer mutexes than objects. Each key (for example,
+// an object id) is mapped to one of the mutexes by hashing it, so that operations on
+// different keys usually do not contend, while operations on the same key always
+// use the same mutex. Keys are hashed with Hash, or with std::hash<Key> if Hash is
+// void.
+//
+// Each mutex is aligned to CRILL_DESTRUCTIVE_INTERFERENCE_SIZE, so that threads
+// locking different mutexes do not contend for the same cache line (false sharing).
+// With small mutexes such as crill::spin_mutex, this makes the table much larger than
+// an array of mutexes: N * CRILL_DESTRUCTIVE_INTERFERENCE_SIZE bytes.
+//
+// Several keys can be locked at once with lock_keys() and lock_key_range(). These
+// always lock the mutexes in the order of their position in the table, and lock each
+// mutex only once even if several keys map to it, so that threads locking
+// overlapping sets of keys cannot deadlock. If locking one of the mutexes throws,
+// the ones already locked are unlocked again before the exception propagates.
+template <typename Mutex, std::size_t N, typename Hash = void>
+class striped_lock
+{
+public:
+    static_assert(N > 0);
+
+    // A lock on a set of mutexes of a crill::striped_lock, which is released when the
+    // object is destroyed.
+    class multi_lock
+    {
+    public:
+        multi_lock(const multi_lock&) = delete;
+        multi_lock& operator=(const multi_lock&) = delete;
+
+        ~multi_lock()
+        {
+            for (std::size_t i = N; i-- > 0;)
+            {
+                if (stripes[i])
+                    table.stripes[i].mutex.unlock();
+            }
+        }
+
+    private:
+        friend class striped_lock;
+
+        multi_lock(striped_lock& table, const std::bitset<N>& stripes)
+          : table(table), stripes(stripes)
+        {
+            std::size_t i = 0;
+            try
+            {
+                for (; i < N; ++i)
+                {
+                    if (stripes[i])
+                        table.stripes[i].mutex.lock();
+                }
+            }
+            catch (...)
+            {
+                // the destructor does not run, so release the mutexes locked so far
+                while (i-- > 0)
+                {
+                    if (stripes[i])
+                        table.stripes[i].mutex.unlock();
+                }
+
+                throw;
+            }
+        }
+
+        striped_lock& table;
+        std::bitset<N> stripes;
+    };
+
+    // Returns: the position in the table of the mutex for the given key.
+    template <typename Key>
+    static std::size_t index_for(const Key& key) noexcept
+    {
+        std::uint64_t h;
+        if constexpr (std::is_void_v<Hash>)
+            h = std::hash<Key>{}(key);
+        else
+            h = Hash{}(key);
+
+        // Many std::hash implementations return integers unchanged, so mix the bits to
+        // spread consecutive keys evenly (Fibonacci hashing).
+        return std::size_t((h * 0x9E3779B97F4A7C15ull) >> 32) % N;
+    }
+
+    // Returns: the mutex for the given key.
+    //
+    //    std::scoped_lock lock(table.lock_for(instrument_id));
+    template <typename Key>
+    Mutex& lock_for(const Key& key) noexcept
+    {
+        return stripes[index_for(key)].mutex;
+    }
+
+    // Effects: Locks the mutexes for all given keys, in a fixed order.
+    // Returns: an object that unlocks them when destroyed.
+    //
+    //    auto lock = table.lock_keys(from_account, to_account);
+    template <typename... Keys>
+    [[nodiscard]] multi_lock lock_keys(const Keys&... keys)
+    {
+        std::bitset<N> selected;
+        (selected.set(index_for(keys)), ...);
+        return multi_lock(*this, selected);
+    }
+
+    // Effects: Locks the mutexes for all keys in the range [first, last), in a fixed
+    // order.
+    // Returns: an object that unlocks them when destroyed.
+    template <typename InputIt>
+    [[nodiscard]] multi_lock lock_key_range(InputIt first, InputIt last)
+    {
+        std::bitset<N> selected;
+        for (; first != last; ++first)
+            selected.set(index_for(*first));
+
+        return multi_lock(*this, selected);
+    }
+
+    // Returns: the number of mutexes in the table.
+    static constexpr std::size_t size() noexcept
+    {
+        return N;
+    }
+
+private:
+    struct alignas(CRILL_DESTRUCTIVE_INTERFERENCE_SIZE) stripe
+    {
+        Mutex mutex;
+    };
+
+    stripe stripes[N];
+};
+
+} // namespace crill
+
+#endif //CRILL_STRIPED_LOCK_H
@@ -0,0 +1,99 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#ifndef CRILL_TICKET_SPIN_MUTEX_H
+#define CRILL_TICKET_SPIN_MUTEX_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <crill/progressive_backoff_wait.h>
+
+namespace crill
+{
+
+// crill::ticket_spin_mutex is a fair spinlock: threads acquire the lock in the
+// order in which they called lock() (FIFO). Unlike with crill::spin_mutex, a thread
+// can therefore not lose the lock repeatedly to other threads that keep locking and
+// unlocking it; its worst-case wait is bounded by the number of threads ahead of it
+// times the longest critical section.
+//
+// crill::ticket_spin_mutex meets the standard C++ requirements for mutex
+// [thread.req.lockable.req] and can therefore be used with std::scoped_lock
+// and std::unique_lock as a drop-in replacement for std::mutex.
+//
+// lock() takes the next ticket and waits until it is being served. While waiting,
+// it backs off in proportion to the number of threads ahead of it, so that threads
+// further back in the queue poll the lock less often, and then waits with
+// crill::progressive_backoff_wait. try_lock() and unlock() are wait-free.
+//
+// Because of the FIFO order, a thread that is preempted while waiting also delays
+// all threads behind it. Prefer crill::spin_mutex if threads contending for the lock
+// can be descheduled for a long time, for example because there are more of them
+// than cores.
+//
+// crill::ticket_spin_mutex is an alias for crill::basic_ticket_spin_mutex with the
+// default backoff policy. Use crill::basic_ticket_spin_mutex directly to choose a
+// different policy from crill/backoff_policy.h.
+template <typename BackoffPolicy = default_progressive>
+class basic_ticket_spin_mutex
+{
+public:
+    // Effects: Acquires the lock. If necessary, blocks until all threads that called
+    // lock() earlier have acquired and released the lock.
+    // Preconditions: The current thread does not already hold the lock.
+    void lock() noexcept
+    {
+        const std::uint32_t ticket = next_ticket.fetch_add(1, std::memory_order_relaxed);
+        if (now_serving.load(std::memory_order_acquire) == ticket)
+            return;
+
+        progressive_backoff_wait<BackoffPolicy>([this, ticket]{
+            const std::uint32_t distance = ticket - now_serving.load(std::memory_order_acquire);
+            if (distance == 0)
+                return true;
+
+            // Approx. 400 ns per thread ahead; the thread that is next in line only
+            // waits with the backoff policy
+            const std::size_t pauses_per_thread = std::max<std::size_t>(
+                impl::backoff_state.pause_count.load(std::memory_order_relaxed), 1);
+            const std::size_t n = (distance - 1) * pauses_per_thread;
+            for (std::size_t i = 0; i < n; ++i)
+                impl::backoff_pause();
+
+            return false;
+        });
+    }
+
+    // Effects: Attempts to acquire the lock without blocking. Fails if the lock is
+    // held, or if other threads are waiting for it.
+    // Returns: true if the lock was acquired, false otherwise.
+    // Non-blocking guarantees: wait-free.
+    bool try_lock() noexcept
+    {
+        std::uint32_t ticket = now_serving.load(std::memory_order_acquire);
+        return next_ticket.compare_exchange_strong(ticket, ticket + 1, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    // Effects: Releases the lock and hands it to the thread that has waited longest.
+    // Preconditions: The lock is being held by the current thread.
+    // Non-blocking guarantees: wait-free.
+    void unlock() noexcept
+    {
+        // Only the thread holding the lock writes now_serving
+        now_serving.store(now_serving.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+    std::atomic<std::uint32_t> next_ticket = 0;
+    std::atomic<std::uint32_t> now_serving = 0;
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+};
+
+using ticket_spin_mutex = basic_ticket_spin_mutex<>;
+
+} // namespace crill
+
+#endif //CRILL_TICKET_SPIN_MUTEX_H
@@ -0,0 +1,113 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#ifndef CRILL_WAIT_FOR_CHANGE_H
+#define CRILL_WAIT_FOR_CHANGE_H
+
+#include <atomic>
+#include <cstring>
+#include <crill/progressive_backoff_wait.h>
+#include <crill/impl/cycle_counter.h>
+#include <crill/impl/waitpkg.h>
+
+namespace crill {
+
+// Effects: Blocks the current thread until the value of the atomic object differs
+// from old, as observed by a load with std::memory_order_acquire.
+//
+// Unlike waiting on an arbitrary predicate, waiting on a specific memory location
+// allows the hardware to put the core into a low-power state until that location
+// is written to, which reduces both power consumption and wakeup latency:
+//
+//  - On Intel CPUs that support WAITPKG, the location is armed with umonitor and
+//    the thread waits with umwait, with a TSC deadline so that it still yields
+//    periodically like crill::progressive_backoff_wait.
+//  - On arm64 (except with MSVC), the location is loaded with an exclusive load
+//    (ldaxr), which arms the exclusive monitor, and the thread waits with wfe. A
+//    write to the location by another core clears the monitor and generates the
+//    event that wakes up the waiting core.
+//  - Otherwise, this is equivalent to crill::progressive_backoff_wait with a
+//    predicate that compares the current value with old.
+template <typename T>
+void wait_for_change(const std::atomic<T>& atomic, T old) noexcept
+{
+    static_assert(std::atomic<T>::is_always_lock_free);
+    static_assert(sizeof(std::atomic<T>) == sizeof(T));
+
+  #if CRILL_HAS_WAITPKG
+    if (impl::has_waitpkg)
+    {
+        CRILL_BACKOFF_COUNT(waits);
+
+        for (std::size_t i = 0; i < impl::progressive_backoff_state::spin_count; ++i)
+        {
+            CRILL_BACKOFF_COUNT(spin_iterations);
+            if (atomic.load(std::memory_order_acquire) != old)
+                return;
+        }
+
+        const std::uint64_t yield_interval_ticks = impl::to_cycle_counter_ticks(
+            std::chrono::nanoseconds(impl::backoff_state.yield_interval_ns.load(std::memory_order_relaxed)));
+
+        while (true)
+        {
+            const std::uint64_t deadline = impl::read_cycle_counter() + yield_interval_ticks;
+            do
+            {
+                // Arm the monitor before checking the value, so that a write between
+                // the check and umwait makes umwait return immediately.
+                CRILL_BACKOFF_COUNT(pause_block_iterations);
+                impl::umonitor(&atomic);
+                if (atomic.load(std::memory_order_acquire) != old)
+                    return;
+
+                impl::umwait(deadline);
+            }
+            while (impl::read_cycle_counter() < deadline);
+
+            // waiting longer than we should, let's give other threads a chance to recover
+            CRILL_BACKOFF_COUNT(yields);
+            std::this_thread::yield();
+        }
+    }
+  #elif CRILL_ARM_64BIT && !defined(_MSC_VER)
+    CRILL_BACKOFF_COUNT(waits);
+
+    for (std::size_t i = 0; i < impl::progressive_backoff_state::spin_count; ++i)
+    {
+        CRILL_BACKOFF_COUNT(spin_iterations);
+        if (atomic.load(std::memory_order_acquire) != old)
+            return;
+    }
+
+    std::uint64_t old_bits = 0;
+    std::memcpy(&old_bits, &old, sizeof(T));
+
+    while (true)
+    {
+        const std::size_t n = impl::backoff_state.pause_block_count.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            // If the location is written between the exclusive load and wfe,
+            // the event register is already set and wfe returns immediately.
+            CRILL_BACKOFF_COUNT(pause_block_iterations);
+            if (impl::load_exclusive_acquire<sizeof(T)>(&atomic) != old_bits)
+                return;
+
+            impl::wfe();
+        }
+
+        // waiting longer than we should, let's give other threads a chance to recover
+        CRILL_BACKOFF_COUNT(yields);
+        std::this_thread::yield();
+    }
+  #endif
+
+    progressive_backoff_wait([&]{ return atomic.load(std::memory_order_acquire) != old; });
+}
+
+} // namespace crill
+
+#endif //CRILL_WAIT_FOR_CHANGE_H
@@ -0,0 +1,65 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#include <atomic>
+#include <thread>
+#include <crill/adaptive_backoff.h>
+#include <doctest/doctest.h>
+
+TEST_CASE("crill::adaptive_backoff")
+{
+    crill::adaptive_backoff backoff;
+    REQUIRE(backoff.expected_wait().count() == 0);
+
+    SUBCASE("Waiting on a true predicate immediately returns and does not change the estimate")
+    {
+        crill::progressive_backoff_wait([]{ return true; }, backoff);
+        CHECK(backoff.expected_wait().count() == 0);
+    }
+
+    SUBCASE("Short waits increase the estimate")
+    {
+        for (int i = 0; i < 20; ++i)
+        {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(50);
+            crill::progressive_backoff_wait([&]{ return std::chrono::steady_clock::now() >= deadline; }, backoff);
+        }
+
+        CHECK(backoff.expected_wait() > std::chrono::microseconds(10));
+        CHECK(backoff.expected_wait() < std::chrono::milliseconds(1));
+    }
+
+    SUBCASE("Long waits decrease the estimate")
+    {
+        for (int i = 0; i < 20; ++i)
+        {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(50);
+            crill::progressive_backoff_wait([&]{ return std::chrono::steady_clock::now() >= deadline; }, backoff);
+        }
+
+        auto short_estimate = backoff.expected_wait();
+
+        for (int i = 0; i < 5; ++i)
+        {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(5);
+            crill::progressive_backoff_wait([&]{ return std::chrono::steady_clock::now() >= deadline; }, backoff);
+        }
+
+        CHECK(backoff.expected_wait() < short_estimate);
+    }
+
+    SUBCASE("Waiting on a false predicate blocks until predicate becomes true")
+    {
+        std::atomic<bool> flag = false;
+        std::thread setter_thread([&]{
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            flag = true;
+        });
+
+        crill::progressive_backoff_wait([&]{ return flag == true; }, backoff);
+        CHECK(flag);
+        setter_thread.join();
+    }
+}
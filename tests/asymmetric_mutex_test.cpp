@@ -0,0 +1,106 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <crill/asymmetric_mutex.h>
+#include <doctest/doctest.h>
+
+TEST_CASE("crill::asymmetric_mutex")
+{
+    static_assert(std::is_default_constructible_v<crill::asymmetric_mutex>);
+    static_assert(!std::is_copy_constructible_v<crill::asymmetric_mutex>);
+    static_assert(!std::is_move_constructible_v<crill::asymmetric_mutex>);
+
+    crill::asymmetric_mutex mtx;
+    auto preferred = mtx.preferred();
+
+    SUBCASE("If mutex is not locked, try_lock succeeds on both sides")
+    {
+        REQUIRE(preferred.try_lock());
+        preferred.unlock();
+        REQUIRE(mtx.try_lock());
+        mtx.unlock();
+    }
+
+    SUBCASE("If mutex is locked by the preferred side, try_lock fails on the other side")
+    {
+        std::scoped_lock lock(preferred);
+        CHECK_FALSE(mtx.try_lock());
+    }
+
+    SUBCASE("If mutex is locked by the other side, try_lock fails on both sides")
+    {
+        std::thread other_thread([&]{
+            std::scoped_lock lock(mtx);
+            CHECK_FALSE(preferred.try_lock());
+        });
+        other_thread.join();
+
+        CHECK(preferred.try_lock());
+        preferred.unlock();
+    }
+
+    SUBCASE("Lock on one side succeeds after the other side releases the mutex")
+    {
+        std::atomic<bool> held_by_other_thread = false;
+
+        std::thread other_thread([&] {
+            std::unique_lock lock(mtx);
+            held_by_other_thread = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        });
+
+        while (!held_by_other_thread)
+            /* wait for other_thread to lock mtx */;
+
+        std::unique_lock lock(preferred);
+        CHECK(lock.owns_lock());
+        other_thread.join();
+    }
+
+    SUBCASE("Preferred thread and other threads exclude each other")
+    {
+        const int num_other_threads = 2;
+        const int num_preferred_iterations = 100'000;
+        const int num_other_iterations = 200;
+        int a = 0, b = 0;
+        std::atomic<bool> torn = false;
+
+        auto increment = [&]{
+            if (a != b)
+                torn = true;
+
+            ++a;
+            ++b;
+        };
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < num_other_threads; ++i)
+        {
+            threads.emplace_back([&]{
+                for (int j = 0; j < num_other_iterations; ++j)
+                {
+                    std::scoped_lock lock(mtx);
+                    increment();
+                }
+            });
+        }
+
+        for (int j = 0; j < num_preferred_iterations; ++j)
+        {
+            std::scoped_lock lock(preferred);
+            increment();
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        CHECK_FALSE(torn);
+        CHECK(a == num_preferred_iterations + num_other_threads * num_other_iterations);
+        CHECK(b == a);
+    }
+}
@@ -0,0 +1,88 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+// This file is compiled into a separate test executable with CRILL_BACKOFF_TELEMETRY
+// defined, see CMakeLists.txt.
+
+#include <atomic>
+#include <thread>
+#include <crill/backoff_telemetry.h>
+#include <crill/parking_spot.h>
+#include <doctest/doctest.h>
+
+TEST_CASE("Backoff telemetry")
+{
+    static_assert(crill::backoff_telemetry_enabled);
+
+    auto before = crill::get_this_thread_backoff_telemetry();
+
+    SUBCASE("Counts a wait that succeeds immediately as one spin iteration")
+    {
+        crill::progressive_backoff_wait([]{ return true; });
+
+        auto after = crill::get_this_thread_backoff_telemetry();
+        CHECK(after.waits == before.waits + 1);
+        CHECK(after.spin_iterations == before.spin_iterations + 1);
+        CHECK(after.pause_iterations == before.pause_iterations);
+        CHECK(after.pause_block_iterations == before.pause_block_iterations);
+        CHECK(after.yields == before.yields);
+    }
+
+    SUBCASE("Counts iterations in each phase of a bounded wait")
+    {
+        CHECK_FALSE(crill::progressive_backoff_try_wait<crill::realtime_bounded<2, 3, 4>>([]{ return false; }));
+
+        auto after = crill::get_this_thread_backoff_telemetry();
+        CHECK(after.waits == before.waits + 1);
+        CHECK(after.spin_iterations == before.spin_iterations + 2);
+        CHECK(after.pause_iterations == before.pause_iterations + 3);
+        CHECK(after.pause_block_iterations == before.pause_block_iterations + 4);
+        CHECK(after.yields == before.yields);
+    }
+
+    SUBCASE("Counts yields")
+    {
+        CHECK_FALSE(crill::progressive_backoff_wait_for([]{ return false; }, std::chrono::milliseconds(5)));
+
+        auto after = crill::get_this_thread_backoff_telemetry();
+        CHECK(after.pause_block_iterations > before.pause_block_iterations);
+        CHECK(after.yields > before.yields);
+    }
+
+    SUBCASE("Counts of other threads are included in the total, also after they exit")
+    {
+        auto total_before = crill::get_backoff_telemetry();
+
+        std::thread other_thread([]{
+            crill::progressive_backoff_try_wait<crill::realtime_bounded<1, 0, 0>>([]{ return false; });
+            auto other = crill::get_this_thread_backoff_telemetry();
+            CHECK(other.waits == 1);
+            CHECK(other.spin_iterations == 1);
+        });
+        other_thread.join();
+
+        auto total_after = crill::get_backoff_telemetry();
+        CHECK(total_after.waits == total_before.waits + 1);
+        CHECK(total_after.spin_iterations == total_before.spin_iterations + 1);
+    }
+
+    SUBCASE("Counts parks")
+    {
+        crill::parking_spot spot;
+        std::atomic<bool> flag = false;
+        std::atomic<std::uint64_t> parks = 0;
+
+        std::thread waiter_thread([&]{
+            crill::progressive_backoff_wait([&]{ return flag == true; }, spot);
+            parks = crill::get_this_thread_backoff_telemetry().parks;
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        flag = true;
+        spot.notify_one();
+        waiter_thread.join();
+        CHECK(parks > 0);
+    }
+}
@@ -0,0 +1,176 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+#include <crill/distributed_shared_mutex.h>
+#include <doctest/doctest.h>
+
+TEST_CASE("crill::distributed_shared_mutex")
+{
+    static_assert(std::is_default_constructible_v<crill::distributed_shared_mutex>);
+    static_assert(!std::is_copy_constructible_v<crill::distributed_shared_mutex>);
+    static_assert(!std::is_move_constructible_v<crill::distributed_shared_mutex>);
+
+    crill::distributed_shared_mutex mtx;
+
+    SUBCASE("If mutex is not locked, try_lock and try_lock_shared succeed")
+    {
+        REQUIRE(mtx.try_lock());
+        mtx.unlock();
+        REQUIRE(mtx.try_lock_shared());
+        mtx.unlock_shared();
+    }
+
+    SUBCASE("If mutex is locked exclusively, try_lock and try_lock_shared fail")
+    {
+        std::unique_lock lock(mtx);
+        CHECK_FALSE(mtx.try_lock());
+        CHECK_FALSE(mtx.try_lock_shared());
+    }
+
+    SUBCASE("If mutex is locked shared, try_lock_shared succeeds and try_lock fails")
+    {
+        std::shared_lock lock(mtx);
+        CHECK_FALSE(mtx.try_lock());
+        CHECK(mtx.try_lock_shared());
+        mtx.unlock_shared();
+    }
+
+    SUBCASE("Multiple threads can hold the mutex shared at the same time")
+    {
+        const int num_threads = 4;
+        std::atomic<int> num_readers = 0;
+        std::atomic<bool> stop = false;
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < num_threads; ++i)
+        {
+            threads.emplace_back([&]{
+                std::shared_lock lock(mtx);
+                ++num_readers;
+                while (!stop)
+                    std::this_thread::yield();
+            });
+        }
+
+        while (num_readers < num_threads)
+            std::this_thread::yield();
+
+        CHECK_FALSE(mtx.try_lock());
+        stop = true;
+
+        for (auto& thread : threads)
+            thread.join();
+
+        CHECK(mtx.try_lock());
+        mtx.unlock();
+    }
+
+    SUBCASE("A waiting writer blocks new readers")
+    {
+        std::atomic<bool> writer_done = false;
+        mtx.lock_shared();
+
+        std::thread writer_thread([&]{
+            std::unique_lock lock(mtx);
+            writer_done = true;
+        });
+
+        // wait for the writer to start waiting
+        while (mtx.try_lock_shared())
+        {
+            mtx.unlock_shared();
+            std::this_thread::yield();
+        }
+
+        CHECK_FALSE(writer_done);
+        mtx.unlock_shared();
+        writer_thread.join();
+        CHECK(writer_done);
+
+        CHECK(mtx.try_lock_shared());
+        mtx.unlock_shared();
+    }
+
+    SUBCASE("Readers and writers exclude each other")
+    {
+        const int num_threads = 4;
+        const int num_iterations = 10'000;
+        int a = 0, b = 0;
+        std::atomic<bool> torn_read = false;
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < num_threads; ++i)
+        {
+            threads.emplace_back([&, i]{
+                for (int j = 0; j < num_iterations; ++j)
+                {
+                    if (i % 2 == 0)
+                    {
+                        std::unique_lock lock(mtx);
+                        ++a;
+                        ++b;
+                    }
+                    else
+                    {
+                        std::shared_lock lock(mtx);
+                        if (a != b)
+                            torn_read = true;
+                    }
+                }
+            });
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        CHECK_FALSE(torn_read);
+        CHECK(a == num_iterations * num_threads / 2);
+        CHECK(b == a);
+    }
+}
+
+TEST_CASE("crill::basic_distributed_shared_mutex with more threads than slots")
+{
+    crill::basic_distributed_shared_mutex<crill::default_progressive, 2> mtx;
+    static_assert(sizeof(mtx) == 3 * CRILL_DESTRUCTIVE_INTERFERENCE_SIZE);
+
+    const int num_threads = 5;
+    const int num_iterations = 10'000;
+    int a = 0, b = 0;
+    std::atomic<bool> torn_read = false;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; ++i)
+    {
+        threads.emplace_back([&, i]{
+            for (int j = 0; j < num_iterations; ++j)
+            {
+                if (i == 0)
+                {
+                    std::unique_lock lock(mtx);
+                    ++a;
+                    ++b;
+                }
+                else
+                {
+                    std::shared_lock lock(mtx);
+                    if (a != b)
+                        torn_read = true;
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    CHECK_FALSE(torn_read);
+    CHECK(a == num_iterations);
+    CHECK(b == a);
+}
@@ -0,0 +1,52 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+// This file is compiled into a separate test executable with
+// CRILL_CHECK_MUTEX_OWNERSHIP defined, see CMakeLists.txt.
+
+#include <atomic>
+#include <thread>
+#include <crill/flat_combining.h>
+#include <doctest/doctest.h>
+
+TEST_CASE("crill::flat_combining with ownership checks")
+{
+    SUBCASE("If all slots are taken, apply locks and unlocks the mutex exactly once")
+    {
+        crill::flat_combining<int, crill::spin_mutex, 1> counter(0);
+        std::atomic<bool> combining = false;
+        std::atomic<bool> release = false;
+
+        std::thread combiner_thread([&]{
+            counter.apply([&](int& i) {
+                combining = true;
+                while (!release)
+                    std::this_thread::yield();
+                ++i;
+            });
+        });
+
+        while (!combining)
+            std::this_thread::yield();
+
+        // takes the only slot
+        std::thread publisher_thread([&]{
+            counter.apply([](int& i) { ++i; });
+        });
+
+        std::thread release_thread([&]{
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            release = true;
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        counter.apply([](int& i) { ++i; });
+
+        combiner_thread.join();
+        publisher_thread.join();
+        release_thread.join();
+        CHECK(counter.apply([](int& i) { return i; }) == 3);
+    }
+}
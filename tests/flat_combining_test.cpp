@@ -0,0 +1,95 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <crill/flat_combining.h>
+#include <doctest/doctest.h>
+
+TEST_CASE("crill::flat_combining")
+{
+    SUBCASE("Constructs the protected object from the given arguments")
+    {
+        crill::flat_combining<std::string> str(3, 'x');
+        CHECK(str.apply([](std::string& s) { return s; }) == "xxx");
+    }
+
+    SUBCASE("apply returns the result of the operation")
+    {
+        crill::flat_combining<int> counter(0);
+        CHECK(counter.apply([](int& i) { return ++i; }) == 1);
+        CHECK(counter.apply([](int& i) { return ++i; }) == 2);
+
+        counter.apply([](int& i) { i = 42; });
+        CHECK(counter.apply([](int& i) { return i; }) == 42);
+    }
+
+    SUBCASE("Exceptions are rethrown on the calling thread")
+    {
+        crill::flat_combining<int> counter(0);
+        CHECK_THROWS_AS(counter.apply([](int&) -> int { throw std::runtime_error("error"); }), std::runtime_error);
+        CHECK(counter.apply([](int& i) { return ++i; }) == 1);
+    }
+
+    SUBCASE("Operations of many threads are all executed exactly once")
+    {
+        const int num_threads = 4;
+        const int num_iterations = 10'000;
+        crill::flat_combining<std::vector<int>> values;
+
+        std::vector<std::thread> threads;
+        std::vector<long long> sums(num_threads);
+        for (int i = 0; i < num_threads; ++i)
+        {
+            threads.emplace_back([&, i]{
+                for (int j = 0; j < num_iterations; ++j)
+                {
+                    auto size = values.apply([&](std::vector<int>& v) {
+                        v.push_back(j);
+                        return v.size();
+                    });
+
+                    sums[i] += (long long)size;
+                }
+            });
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        CHECK(values.apply([](std::vector<int>& v) { return v.size(); }) == num_threads * num_iterations);
+
+        // every size from 1 to n was returned to exactly one operation
+        long long total = 0;
+        for (auto s : sums)
+            total += s;
+
+        const long long n = num_threads * num_iterations;
+        CHECK(total == n * (n + 1) / 2);
+    }
+
+    SUBCASE("Works with more threads than slots")
+    {
+        const int num_threads = 4;
+        const int num_iterations = 1000;
+        crill::flat_combining<int, crill::spin_mutex, 2> counter(0);
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < num_threads; ++i)
+        {
+            threads.emplace_back([&]{
+                for (int j = 0; j < num_iterations; ++j)
+                    counter.apply([](int& c) { ++c; });
+            });
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        CHECK(counter.apply([](int& c) { return c; }) == num_threads * num_iterations);
+    }
+}
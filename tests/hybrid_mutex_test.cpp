@@ -0,0 +1,120 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <crill/backoff_policy.h>
+#include <crill/hybrid_mutex.h>
+#include <doctest/doctest.h>
+
+TEST_CASE("crill::hybrid_mutex")
+{
+    static_assert(std::is_default_constructible_v<crill::hybrid_mutex>);
+    static_assert(!std::is_copy_constructible_v<crill::hybrid_mutex>);
+    static_assert(!std::is_move_constructible_v<crill::hybrid_mutex>);
+    static_assert(sizeof(crill::hybrid_mutex) == sizeof(std::uint32_t));
+
+    crill::hybrid_mutex mtx;
+
+    SUBCASE("If mutex is not locked, try_lock succeeds")
+    {
+        REQUIRE(mtx.try_lock());
+        mtx.unlock();
+    }
+
+    SUBCASE("If mutex is locked, try_lock fails")
+    {
+        mtx.lock();
+        REQUIRE_FALSE(mtx.try_lock());
+        mtx.unlock();
+        REQUIRE(mtx.try_lock());
+        mtx.unlock();
+    }
+
+    SUBCASE("Works with std::scoped_lock")
+    {
+        {
+            std::scoped_lock lock(mtx);
+            CHECK_FALSE(mtx.try_lock());
+        }
+
+        CHECK(mtx.try_lock());
+        mtx.unlock();
+    }
+
+    SUBCASE("A thread that went to sleep is woken up when the mutex is released")
+    {
+        std::atomic<bool> held_by_other_thread = false;
+
+        std::thread other_thread([&] {
+            std::unique_lock lock(mtx);
+            held_by_other_thread = true;
+
+            // long enough for the main thread to use up its spin budget
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        });
+
+        while (!held_by_other_thread)
+            /* wait for other_thread to lock mtx */;
+
+        std::unique_lock lock(mtx);
+        CHECK(lock.owns_lock());
+        other_thread.join();
+    }
+
+    SUBCASE("Many threads incrementing a counter")
+    {
+        const int num_threads = 4;
+        const int num_iterations = 10'000;
+        int counter = 0;
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < num_threads; ++i)
+        {
+            threads.emplace_back([&]{
+                for (int j = 0; j < num_iterations; ++j)
+                {
+                    std::scoped_lock lock(mtx);
+                    ++counter;
+                }
+            });
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        CHECK(counter == num_threads * num_iterations);
+    }
+}
+
+TEST_CASE_TEMPLATE("crill::basic_hybrid_mutex with a backoff policy", BackoffPolicy,
+    crill::realtime_never_yield, crill::low_power, crill::exponential_randomized)
+{
+    crill::basic_hybrid_mutex<BackoffPolicy> mtx;
+    const int num_threads = 3;
+    const int num_iterations = 1000;
+    int counter = 0;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; ++i)
+    {
+        threads.emplace_back([&]{
+            for (int j = 0; j < num_iterations; ++j)
+            {
+                std::scoped_lock lock(mtx);
+                ++counter;
+
+                if (j % 100 == 0)
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    CHECK(counter == num_threads * num_iterations);
+}
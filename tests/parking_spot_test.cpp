@@ -0,0 +1,71 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <crill/parking_spot.h>
+#include <doctest/doctest.h>
+
+TEST_CASE("crill::parking_spot")
+{
+    crill::parking_spot spot;
+
+    SUBCASE("Notifying without parked threads does nothing")
+    {
+        spot.notify_one();
+        spot.notify_all();
+    }
+
+    SUBCASE("Waiting on a true predicate immediately returns")
+    {
+        crill::progressive_backoff_wait([]{ return true; }, spot);
+    }
+
+    SUBCASE("Parked thread wakes up on notify_one")
+    {
+        std::atomic<bool> flag = false;
+        std::atomic<bool> waiter_thread_done = false;
+        std::thread waiter_thread([&]{
+            crill::progressive_backoff_wait([&]{ return flag == true; }, spot);
+            waiter_thread_done = true;
+        });
+
+        // give the waiter enough time to use up its spin budget and park
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        REQUIRE_FALSE(waiter_thread_done);
+
+        flag = true;
+        spot.notify_one();
+        waiter_thread.join();
+        REQUIRE(waiter_thread_done);
+    }
+
+    SUBCASE("All parked threads wake up on notify_all")
+    {
+        std::atomic<bool> flag = false;
+        std::atomic<int> threads_done = 0;
+        std::vector<std::thread> waiter_threads;
+
+        for (int i = 0; i < 4; ++i)
+        {
+            waiter_threads.emplace_back([&]{
+                crill::progressive_backoff_wait([&]{ return flag == true; }, spot);
+                ++threads_done;
+            });
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        REQUIRE(threads_done == 0);
+
+        flag = true;
+        spot.notify_all();
+
+        for (auto& thread : waiter_threads)
+            thread.join();
+
+        REQUIRE(threads_done == 4);
+    }
+}
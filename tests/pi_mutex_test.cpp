@@ -0,0 +1,123 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <crill/pi_mutex.h>
+#include <doctest/doctest.h>
+
+#if CRILL_HAS_PI_MUTEX
+  #include <sys/wait.h>
+  #include <unistd.h>
+#endif
+
+#if CRILL_HAS_PI_MUTEX
+TEST_CASE("crill::pi_mutex")
+{
+    static_assert(std::is_default_constructible_v<crill::pi_mutex>);
+    static_assert(!std::is_copy_constructible_v<crill::pi_mutex>);
+    static_assert(!std::is_move_constructible_v<crill::pi_mutex>);
+
+    crill::pi_mutex mtx;
+
+    SUBCASE("If mutex is not locked, try_lock succeeds")
+    {
+        REQUIRE(mtx.try_lock());
+        mtx.unlock();
+    }
+
+    SUBCASE("If mutex is locked, try_lock fails")
+    {
+        mtx.lock();
+        REQUIRE_FALSE(mtx.try_lock());
+        mtx.unlock();
+        REQUIRE(mtx.try_lock());
+        mtx.unlock();
+    }
+
+    SUBCASE("Works with std::scoped_lock")
+    {
+        {
+            std::scoped_lock lock(mtx);
+            CHECK_FALSE(mtx.try_lock());
+        }
+
+        CHECK(mtx.try_lock());
+        mtx.unlock();
+    }
+
+    SUBCASE("If mutex is held by other thread, lock blocks until mutex is released")
+    {
+        std::atomic<bool> held_by_other_thread = false;
+        std::atomic<bool> released = false;
+
+        std::thread other_thread([&] {
+            std::unique_lock lock(mtx);
+            held_by_other_thread = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            released = true;
+        });
+
+        while (!held_by_other_thread)
+            /* wait for other_thread to lock mtx */;
+
+        std::unique_lock lock(mtx);
+        CHECK(lock.owns_lock());
+        CHECK(released);
+        other_thread.join();
+    }
+
+    SUBCASE("Many threads incrementing a counter")
+    {
+        const int num_threads = 4;
+        const int num_iterations = 10'000;
+        int counter = 0;
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < num_threads; ++i)
+        {
+            threads.emplace_back([&]{
+                for (int j = 0; j < num_iterations; ++j)
+                {
+                    std::scoped_lock lock(mtx);
+                    ++counter;
+                }
+            });
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        CHECK(counter == num_threads * num_iterations);
+    }
+
+    SUBCASE("A forked child does not use the thread id of its parent")
+    {
+        // Forking from a second thread, so that the parent's thread id differs from
+        // the process id of both parent and child.
+        bool child_matches = false;
+        std::thread([&]{
+            const auto parent_tid = crill::impl::this_thread_tid();
+            pid_t pid = fork();
+            if (pid == 0)
+                _exit(crill::impl::this_thread_tid() == std::uint32_t(getpid()) ? 0 : 1);
+
+            int status = 0;
+            waitpid(pid, &status, 0);
+            child_matches = parent_tid != std::uint32_t(getpid()) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        }).join();
+
+        CHECK(child_matches);
+    }
+}
+
+TEST_CASE("crill::impl::futex_lock_pi throws if the kernel refuses the lock")
+{
+    std::atomic<std::uint32_t> word = crill::impl::this_thread_tid();
+    CHECK_THROWS_AS(crill::impl::futex_lock_pi(word), std::system_error);
+}
+#endif
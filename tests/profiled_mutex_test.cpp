@@ -0,0 +1,131 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <crill/profiled_mutex.h>
+#include <crill/spin_mutex.h>
+#include <doctest/doctest.h>
+
+namespace
+{
+    crill::lock_profile find_profile(const std::string& name)
+    {
+        for (const auto& profile : crill::get_lock_profiles())
+        {
+            if (profile.name == name)
+                return profile;
+        }
+
+        return {};
+    }
+}
+
+TEST_CASE("crill::profiled")
+{
+    static_assert(!std::is_default_constructible_v<crill::profiled<crill::spin_mutex>>);
+
+    SUBCASE("Works with std::scoped_lock and std::unique_lock")
+    {
+        crill::profiled<crill::spin_mutex> mtx("profiled_test_lockable");
+        {
+            std::scoped_lock lock(mtx);
+            CHECK_FALSE(mtx.try_lock());
+        }
+
+        std::unique_lock lock(mtx, std::chrono::microseconds(20));
+        CHECK(lock.owns_lock());
+    }
+
+    SUBCASE("Uncontended acquisitions are counted")
+    {
+        crill::profiled<crill::spin_mutex> mtx("profiled_test_uncontended");
+        for (int i = 0; i < 10; ++i)
+        {
+            std::scoped_lock lock(mtx);
+        }
+
+        CHECK(mtx.try_lock());
+        CHECK_FALSE(mtx.try_lock());
+        mtx.unlock();
+
+        auto profile = find_profile("profiled_test_uncontended");
+        CHECK(profile.acquisitions == 11);
+        CHECK(profile.contended_acquisitions == 0);
+        CHECK(profile.failed_try_locks == 1);
+        CHECK(profile.total_wait.count() == 0);
+    }
+
+    SUBCASE("Contended acquisitions record the wait and hold time")
+    {
+        crill::profiled<crill::spin_mutex> mtx("profiled_test_contended");
+        std::atomic<bool> held_by_other_thread = false;
+
+        std::thread other_thread([&] {
+            std::unique_lock lock(mtx);
+            held_by_other_thread = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        });
+
+        while (!held_by_other_thread)
+            /* wait for other_thread to lock mtx */;
+
+        mtx.lock();
+        mtx.unlock();
+        other_thread.join();
+
+        auto profile = find_profile("profiled_test_contended");
+        CHECK(profile.acquisitions == 2);
+        CHECK(profile.contended_acquisitions == 1);
+        CHECK(profile.max_wait > std::chrono::milliseconds(1));
+        CHECK(profile.total_wait == profile.max_wait);
+        CHECK(profile.total_hold > std::chrono::milliseconds(5));
+    }
+
+  #if CRILL_INTEL
+    SUBCASE("Durations are accurate even if the cycle counter is not calibrated")
+    {
+        auto calibrated = crill::impl::cycle_counter_ticks_per_ns.load();
+        crill::impl::cycle_counter_ticks_per_ns = calibrated * 2;
+
+        crill::profiled<crill::spin_mutex> mtx("profiled_test_uncalibrated");
+        mtx.lock();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        mtx.unlock();
+
+        auto profile = find_profile("profiled_test_uncalibrated");
+        crill::impl::cycle_counter_ticks_per_ns = calibrated;
+
+        CHECK(profile.total_hold > std::chrono::milliseconds(15));
+    }
+  #endif
+
+    SUBCASE("Mutexes with the same name share a record")
+    {
+        {
+            crill::profiled<crill::spin_mutex> mtx1("profiled_test_shared");
+            crill::profiled<crill::spin_mutex> mtx2("profiled_test_shared");
+            std::scoped_lock lock(mtx1, mtx2);
+        }
+        {
+            crill::profiled<crill::spin_mutex> mtx3("profiled_test_shared");
+            std::scoped_lock lock(mtx3);
+        }
+
+        CHECK(find_profile("profiled_test_shared").acquisitions >= 3);
+    }
+
+    SUBCASE("The report is sorted by total wait time")
+    {
+        auto profiles = crill::get_lock_profiles();
+        for (std::size_t i = 1; i < profiles.size(); ++i)
+            CHECK(profiles[i - 1].total_wait >= profiles[i].total_wait);
+
+        std::ostringstream report;
+        crill::write_lock_profile_report(report);
+        CHECK(report.str().find("name\tacquisitions") == 0);
+    }
+}
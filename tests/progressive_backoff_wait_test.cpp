@@ -4,8 +4,11 @@
 // (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
 
 #include <atomic>
+#include <ctime>
 #include <thread>
 #include <crill/progressive_backoff_wait.h>
+#include <crill/backoff_telemetry.h>
+#include <crill/stop_token.h>
 #include <doctest/doctest.h>
 
 TEST_CASE("Waiting on a true predicate immediately returns")
@@ -33,3 +36,248 @@ TEST_CASE("Waiting on a false predicate blocks until predicate becomes true")
     waiter_thread.join();
     REQUIRE(waiter_thread_done);
 }
+
+TEST_CASE("Progressive backoff timings are calibrated at startup")
+{
+    auto timings = crill::get_progressive_backoff_timings();
+    REQUIRE(timings.pause_duration.count() > 0);
+    REQUIRE(timings.pause_phase.count() > 0);
+    REQUIRE(timings.yield_interval.count() > 0);
+}
+
+TEST_CASE("Progressive backoff timings can be overridden")
+{
+    auto original = crill::get_progressive_backoff_timings();
+
+    crill::set_progressive_backoff_timings({
+        std::chrono::duration<double, std::nano>(20.0),
+        std::chrono::nanoseconds(200),
+        std::chrono::microseconds(100)});
+
+    auto timings = crill::get_progressive_backoff_timings();
+    CHECK(timings.pause_duration.count() == 20.0);
+    CHECK(timings.pause_phase == std::chrono::nanoseconds(200));
+    CHECK(timings.yield_interval == std::chrono::microseconds(100));
+
+    SUBCASE("Waiting still works with the new timings")
+    {
+        int i = 0;
+        crill::progressive_backoff_wait([&]{ return ++i == 100; });
+        CHECK(i == 100);
+    }
+
+    SUBCASE("Recalibrating keeps the phase durations")
+    {
+        timings = crill::calibrate_progressive_backoff();
+        CHECK(timings.pause_duration.count() > 0);
+        CHECK(timings.pause_phase == std::chrono::nanoseconds(200));
+        CHECK(timings.yield_interval == std::chrono::microseconds(100));
+    }
+
+    crill::set_progressive_backoff_timings(original);
+}
+
+TEST_CASE("Timed wait on a true predicate immediately returns true")
+{
+    CHECK(crill::progressive_backoff_wait_for([]{ return true; }, std::chrono::milliseconds(0)));
+    CHECK(crill::progressive_backoff_wait_until([]{ return true; }, std::chrono::steady_clock::now()));
+}
+
+TEST_CASE("Timed wait on a false predicate times out")
+{
+    using namespace std::chrono;
+
+    SUBCASE("wait_for")
+    {
+        auto start = steady_clock::now();
+        CHECK_FALSE(crill::progressive_backoff_wait_for([]{ return false; }, milliseconds(5)));
+        CHECK(steady_clock::now() - start >= milliseconds(5));
+    }
+
+    SUBCASE("wait_until")
+    {
+        auto deadline = steady_clock::now() + milliseconds(5);
+        CHECK_FALSE(crill::progressive_backoff_wait_until([]{ return false; }, deadline));
+        CHECK(steady_clock::now() >= deadline);
+    }
+
+    SUBCASE("wait_until with a different clock")
+    {
+        auto start = steady_clock::now();
+        CHECK_FALSE(crill::progressive_backoff_wait_until([]{ return false; }, system_clock::now() + milliseconds(5)));
+        CHECK(steady_clock::now() - start >= milliseconds(4));
+    }
+}
+
+TEST_CASE("Timed wait returns true when predicate becomes true before the timeout")
+{
+    std::atomic<bool> flag = false;
+    std::thread setter_thread([&]{
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        flag = true;
+    });
+
+    CHECK(crill::progressive_backoff_wait_for([&]{ return flag == true; }, std::chrono::hours(1)));
+    setter_thread.join();
+}
+
+TEST_CASE("Timed wait with a very long timeout does not overflow")
+{
+    int i = 0;
+    CHECK(crill::progressive_backoff_wait_for([&]{ return ++i == 10; }, std::chrono::nanoseconds::max()));
+    CHECK(crill::progressive_backoff_wait_until([&]{ return ++i == 20; }, std::chrono::steady_clock::time_point::max()));
+}
+
+TEST_CASE_TEMPLATE("Waiting with a backoff policy", BackoffPolicy,
+    crill::default_progressive, crill::realtime_never_yield, crill::low_power, crill::exponential_randomized)
+{
+    SUBCASE("Waiting on a true predicate immediately returns")
+    {
+        crill::progressive_backoff_wait<BackoffPolicy>([]{ return true; });
+    }
+
+    SUBCASE("Waiting on a false predicate blocks until predicate becomes true")
+    {
+        std::atomic<bool> flag = false;
+        std::atomic<bool> waiter_thread_done = false;
+        std::thread waiter_thread([&]{
+            crill::progressive_backoff_wait<BackoffPolicy>([&]{ return flag == true; });
+            waiter_thread_done = true;
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        REQUIRE_FALSE(waiter_thread_done);
+
+        flag = true;
+        waiter_thread.join();
+        REQUIRE(waiter_thread_done);
+    }
+
+    SUBCASE("Timed wait on a false predicate times out")
+    {
+        auto start = std::chrono::steady_clock::now();
+        CHECK_FALSE(crill::progressive_backoff_wait_for<BackoffPolicy>([]{ return false; }, std::chrono::milliseconds(5)));
+        CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(5));
+    }
+}
+
+TEST_CASE("Bounded real-time wait")
+{
+    using policy = crill::realtime_bounded<2, 3, 4>;
+
+    SUBCASE("Waiting on a true predicate immediately returns true")
+    {
+        CHECK(crill::progressive_backoff_try_wait<policy>([]{ return true; }));
+    }
+
+    SUBCASE("Waiting on a false predicate fails after a fixed number of iterations")
+    {
+        int i = 0;
+        CHECK_FALSE(crill::progressive_backoff_try_wait<policy>([&]{ ++i; return false; }));
+        CHECK(i == 2 + 3 + 4);
+    }
+
+    SUBCASE("Waiting succeeds if predicate becomes true within the budget")
+    {
+        int i = 0;
+        CHECK(crill::progressive_backoff_try_wait<policy>([&]{ return ++i == 7; }));
+        CHECK(i == 7);
+    }
+
+    SUBCASE("Untimed wait starts over until predicate becomes true")
+    {
+        int i = 0;
+        crill::progressive_backoff_wait<policy>([&]{ return ++i == 100; });
+        CHECK(i == 100);
+    }
+
+    SUBCASE("Policies that never give up always succeed")
+    {
+        int i = 0;
+        CHECK(crill::progressive_backoff_try_wait([&]{ return ++i == 100; }));
+    }
+}
+
+TEST_CASE("Backoff telemetry is disabled by default")
+{
+    static_assert(!crill::backoff_telemetry_enabled);
+
+    crill::progressive_backoff_wait([]{ return true; });
+    CHECK(crill::get_backoff_telemetry().waits == 0);
+    CHECK(crill::get_this_thread_backoff_telemetry().waits == 0);
+}
+
+TEST_CASE("Waiting with a stop token")
+{
+    crill::stop_source source;
+
+    SUBCASE("Waiting on a true predicate immediately returns true")
+    {
+        CHECK(crill::progressive_backoff_wait([]{ return true; }, source.get_token()));
+    }
+
+    SUBCASE("Waiting with a token that has already been stopped immediately returns false")
+    {
+        source.request_stop();
+        CHECK_FALSE(crill::progressive_backoff_wait([]{ return false; }, source.get_token()));
+    }
+
+    SUBCASE("Waiting with a token without stop_source blocks until predicate becomes true")
+    {
+        int i = 0;
+        CHECK(crill::progressive_backoff_wait([&]{ return ++i == 100; }, crill::stop_token()));
+    }
+
+    SUBCASE("Requesting a stop cancels the wait")
+    {
+        std::atomic<bool> waiter_thread_running = false;
+        std::atomic<bool> waiter_thread_done = false;
+        bool result = true;
+
+        std::thread waiter_thread([&]{
+            waiter_thread_running = true;
+            result = crill::progressive_backoff_wait([]{ return false; }, source.get_token());
+            waiter_thread_done = true;
+        });
+
+        while (!waiter_thread_running)
+            /* wait for thread to start*/;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        REQUIRE_FALSE(waiter_thread_done);
+
+        source.request_stop();
+        waiter_thread.join();
+        CHECK_FALSE(result);
+    }
+
+    SUBCASE("Cancellation works with a bounded policy")
+    {
+        std::thread stopper_thread([&]{
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            source.request_stop();
+        });
+
+        auto token = source.get_token();
+        CHECK_FALSE(crill::progressive_backoff_wait<crill::realtime_bounded<>>([&]{ return false; }, token));
+        stopper_thread.join();
+    }
+
+    SUBCASE("Low-power policy sleeps instead of yielding while waiting for a stop")
+    {
+        std::thread stopper_thread([&]{
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            source.request_stop();
+        });
+
+        auto token = source.get_token();
+        auto cpu_start = std::clock();
+        auto wall_start = std::chrono::steady_clock::now();
+        CHECK_FALSE(crill::progressive_backoff_wait<crill::low_power>([&]{ return false; }, token));
+        auto wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+        auto cpu_time = double(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+        stopper_thread.join();
+
+        CHECK(cpu_time < wall_time / 4);
+    }
+}
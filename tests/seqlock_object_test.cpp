@@ -10,6 +10,7 @@
 #include <crill/seqlock_object.h>
 #include <doctest/doctest.h>
 #include <thread>
+#include <vector>
 
 TEST_CASE("crill::seqlock_object")
 {
@@ -116,3 +117,75 @@ TEST_CASE("crill::seqlock_object with size that is not a multiple of size_t")
     obj.store('x');
     REQUIRE(obj.load() == 'x');
 }
+
+TEST_CASE("crill::seqlock_object with a backoff policy")
+{
+    crill::seqlock_object<int, crill::low_power> obj(42);
+    REQUIRE(obj.load() == 42);
+    obj.store(43);
+    REQUIRE(obj.load() == 43);
+}
+
+TEST_CASE("crill::multi_writer_seqlock_object")
+{
+    struct value
+    {
+        std::size_t a = 0;
+        std::size_t writer = 0;
+        std::size_t b = 0;
+    };
+
+    static_assert(std::is_same_v<crill::multi_writer_seqlock_object<value>,
+        crill::seqlock_object<value, crill::default_progressive, crill::seqlock_writers::multiple>>);
+
+    crill::multi_writer_seqlock_object<value> obj;
+
+    SUBCASE("store and load")
+    {
+        obj.store({1, 2, 3});
+        value v = obj.load();
+        REQUIRE(v.a == 1);
+        REQUIRE(v.writer == 2);
+        REQUIRE(v.b == 3);
+    }
+
+    SUBCASE("Concurrent stores from multiple writers")
+    {
+        const std::size_t num_writers = 3;
+        const std::size_t num_iterations = 10'000;
+        std::atomic<bool> torn_read = false;
+        std::atomic<bool> stop = false;
+
+        std::thread reader([&] {
+            while (!stop)
+            {
+                value v = obj.load();
+                if (v.a != v.b)
+                    torn_read = true;
+            }
+        });
+
+        std::vector<std::thread> writers;
+        for (std::size_t w = 0; w < num_writers; ++w)
+        {
+            writers.emplace_back([&, w] {
+                for (std::size_t i = 1; i <= num_iterations; ++i)
+                    obj.store({i, w, i});
+            });
+        }
+
+        for (auto& writer : writers)
+            writer.join();
+
+        stop = true;
+        reader.join();
+
+        CHECK_FALSE(torn_read);
+
+        value v;
+        REQUIRE(obj.try_load(v));
+        CHECK(v.a == num_iterations);
+        CHECK(v.b == num_iterations);
+        CHECK(v.writer < num_writers);
+    }
+}
@@ -0,0 +1,165 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <crill/seqlock_object.h>
+#include <crill/shared_memory_object.h>
+#include <crill/spin_mutex.h>
+#include <doctest/doctest.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+  #include <sys/wait.h>
+  #include <unistd.h>
+
+namespace
+{
+    struct parameters
+    {
+        float gain = 1.0f;
+        int mode = 0;
+    };
+
+    struct shared_state
+    {
+        crill::seqlock_object<parameters> params;
+        crill::spin_mutex mtx;
+        int counter = 0;
+    };
+
+    struct throws_on_construction
+    {
+        explicit throws_on_construction(bool should_throw)
+        {
+            if (should_throw)
+                throw std::runtime_error("construction failed");
+        }
+
+        int value = 0;
+    };
+
+    std::string unique_name(const char* suffix)
+    {
+        return "/crill_test_" + std::to_string(getpid()) + "_" + suffix;
+    }
+}
+
+TEST_CASE("crill::shared_memory_object")
+{
+    SUBCASE("The first instance creates the region, later ones attach to it")
+    {
+        auto name = unique_name("create");
+        {
+            crill::shared_memory_object<shared_state> a(name.c_str());
+            crill::shared_memory_object<shared_state> b(name.c_str());
+            CHECK(a.created());
+            CHECK_FALSE(b.created());
+
+            // same object, mapped at two different addresses
+            CHECK(&a.get() != &b.get());
+            a->params.store({ 0.5f, 3 });
+            CHECK(b->params.load().gain == 0.5f);
+            CHECK(b->params.load().mode == 3);
+
+            a->mtx.lock();
+            CHECK_FALSE(b->mtx.try_lock());
+            a->mtx.unlock();
+            CHECK(b->mtx.try_lock());
+            b->mtx.unlock();
+        }
+
+        CHECK(crill::shared_memory_object<shared_state>::remove(name.c_str()));
+        CHECK_FALSE(crill::shared_memory_object<shared_state>::remove(name.c_str()));
+    }
+
+    SUBCASE("The object is constructed from the given arguments")
+    {
+        auto name = unique_name("args");
+        crill::shared_memory_object<crill::seqlock_object<int>> a(name.c_str(), 0, 42);
+        crill::shared_memory_object<crill::seqlock_object<int>> b(name.c_str(), 0, 7);
+        CHECK(b->load() == 42);
+        crill::shared_memory_object<int>::remove(name.c_str());
+    }
+
+    SUBCASE("Attaching with a different layout immediately throws")
+    {
+        auto name = unique_name("layout");
+        crill::shared_memory_object<parameters> a(name.c_str(), 1);
+        auto start = std::chrono::steady_clock::now();
+
+        auto throws_different_layout = [&](auto&& attach) {
+            try
+            {
+                attach();
+            }
+            catch (const std::runtime_error& e)
+            {
+                return std::string(e.what()).find("different layout") != std::string::npos;
+            }
+
+            return false;
+        };
+
+        // different user_version
+        CHECK(throws_different_layout([&]{ crill::shared_memory_object<parameters>(name.c_str(), 2); }));
+        // different T that fits in the existing region
+        CHECK(throws_different_layout([&]{ crill::shared_memory_object<int>(name.c_str(), 1); }));
+        // different T that does not
+        CHECK(throws_different_layout([&]{ crill::shared_memory_object<shared_state>(name.c_str(), 1); }));
+
+        CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+        crill::shared_memory_object<parameters>::remove(name.c_str());
+    }
+
+    SUBCASE("If the constructor of the object throws, the region is removed")
+    {
+        auto name = unique_name("throw");
+        using object = crill::shared_memory_object<throws_on_construction>;
+        CHECK_THROWS_AS(object(name.c_str(), 0, true), std::runtime_error);
+        CHECK_FALSE(object::remove(name.c_str()));
+
+        object a(name.c_str(), 0, false);
+        CHECK(a.created());
+        object::remove(name.c_str());
+    }
+
+    SUBCASE("Processes synchronise through the shared object")
+    {
+        auto name = unique_name("fork");
+        crill::shared_memory_object<shared_state> state(name.c_str());
+        const int num_iterations = 10'000;
+
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            crill::shared_memory_object<shared_state> child_state(name.c_str());
+            for (int i = 0; i < num_iterations; ++i)
+            {
+                std::scoped_lock lock(child_state->mtx);
+                ++child_state->counter;
+            }
+
+            child_state->params.store({ 2.0f, 1 });
+            _exit(0);
+        }
+
+        for (int i = 0; i < num_iterations; ++i)
+        {
+            std::scoped_lock lock(state->mtx);
+            ++state->counter;
+        }
+
+        int status = 0;
+        waitpid(pid, &status, 0);
+        CHECK(WIFEXITED(status));
+        CHECK(state->counter == 2 * num_iterations);
+        CHECK(state->params.load().gain == 2.0f);
+
+        crill::shared_memory_object<shared_state>::remove(name.c_str());
+    }
+}
+#endif
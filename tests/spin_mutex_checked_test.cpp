@@ -0,0 +1,101 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+// This file is compiled into a separate test executable with
+// CRILL_CHECK_MUTEX_OWNERSHIP defined, see CMakeLists.txt.
+
+#include <csignal>
+#include <mutex>
+#include <thread>
+#include <crill/spin_mutex.h>
+#include <doctest/doctest.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+  #include <sys/wait.h>
+  #include <unistd.h>
+
+namespace
+{
+    // Returns: true if f aborts the program when run in a child process.
+    template <typename F>
+    bool aborts(F&& f)
+    {
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            std::freopen("/dev/null", "w", stderr);
+            f();
+            _exit(0);
+        }
+
+        int status = 0;
+        waitpid(pid, &status, 0);
+        return WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT;
+    }
+}
+#endif
+
+TEST_CASE("crill::spin_mutex with ownership checks")
+{
+    static_assert(sizeof(crill::spin_mutex) > 1);
+
+    SUBCASE("Correct usage does not abort")
+    {
+        crill::spin_mutex mtx;
+        {
+            std::scoped_lock lock(mtx);
+            CHECK_FALSE(mtx.try_lock());
+        }
+
+        std::thread other_thread([&]{
+            std::unique_lock lock(mtx, std::chrono::milliseconds(1));
+            CHECK(lock.owns_lock());
+        });
+        other_thread.join();
+
+        CHECK(mtx.try_lock());
+        mtx.unlock();
+    }
+
+  #if defined(__unix__) || defined(__APPLE__)
+    SUBCASE("Recursive lock aborts")
+    {
+        CHECK(aborts([]{
+            crill::spin_mutex mtx;
+            mtx.lock();
+            mtx.lock();
+        }));
+
+        CHECK(aborts([]{
+            crill::spin_mutex mtx;
+            mtx.lock();
+            (void)mtx.try_lock_for(std::chrono::milliseconds(1));
+        }));
+    }
+
+    SUBCASE("Unlock by a thread not holding the lock aborts")
+    {
+        CHECK(aborts([]{
+            crill::spin_mutex mtx;
+            mtx.unlock();
+        }));
+
+        CHECK(aborts([]{
+            crill::spin_mutex mtx;
+            mtx.lock();
+            std::thread other_thread([&]{ mtx.unlock(); });
+            other_thread.join();
+        }));
+    }
+
+    SUBCASE("Destruction while locked aborts")
+    {
+        CHECK(aborts([]{
+            crill::spin_mutex mtx;
+            mtx.lock();
+        }));
+    }
+  #endif
+}
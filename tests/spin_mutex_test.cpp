@@ -13,6 +13,7 @@ TEST_CASE("crill::spin_mutex")
     static_assert(!std::is_copy_assignable_v<crill::spin_mutex>);
     static_assert(!std::is_move_constructible_v<crill::spin_mutex>);
     static_assert(!std::is_move_assignable_v<crill::spin_mutex>);
+    static_assert(sizeof(crill::spin_mutex) == 1);
 
     crill::spin_mutex mtx;
 
@@ -100,5 +101,79 @@ TEST_CASE("crill::spin_mutex")
         other_thread.join();
     }
 
+    SUBCASE("If mutex is not locked, try_lock_for and try_lock_until succeed")
+    {
+        REQUIRE(mtx.try_lock_for(std::chrono::microseconds(20)));
+        mtx.unlock();
+        REQUIRE(mtx.try_lock_until(std::chrono::steady_clock::now()));
+        mtx.unlock();
+    }
+
+    SUBCASE("If mutex is locked, try_lock_for fails after the timeout")
+    {
+        mtx.lock();
+        auto start = std::chrono::steady_clock::now();
+        CHECK_FALSE(mtx.try_lock_for(std::chrono::milliseconds(5)));
+        CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(5));
+
+        CHECK_FALSE(mtx.try_lock_until(std::chrono::system_clock::now() + std::chrono::milliseconds(1)));
+        mtx.unlock();
+    }
+
+    SUBCASE("Works with the timed constructors of std::unique_lock")
+    {
+        {
+            std::unique_lock lock(mtx, std::chrono::microseconds(20));
+            CHECK(lock.owns_lock());
+
+            std::thread other_thread([&] {
+                std::unique_lock other_lock(mtx, std::chrono::steady_clock::now() + std::chrono::microseconds(20));
+                CHECK_FALSE(other_lock.owns_lock());
+            });
+            other_thread.join();
+        }
+
+        CHECK(mtx.try_lock());
+        mtx.unlock();
+    }
+
+    SUBCASE("If mutex is held by other thread, try_lock_for succeeds if mutex is released in time")
+    {
+        std::atomic<bool> held_by_other_thread = false;
+
+        std::thread other_thread([&] {
+            std::unique_lock lock(mtx);
+            held_by_other_thread = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        });
+
+        while (!held_by_other_thread)
+            /* wait for other_thread to lock mtx */;
+
+        CHECK(mtx.try_lock_for(std::chrono::seconds(10)));
+        mtx.unlock();
+        other_thread.join();
+    }
+
     // TODO: add test where many threads are poking the mutex simultaneously, and run with threadsan
 }
+
+TEST_CASE_TEMPLATE("crill::basic_spin_mutex with a backoff policy", BackoffPolicy,
+    crill::realtime_never_yield, crill::low_power, crill::exponential_randomized)
+{
+    crill::basic_spin_mutex<BackoffPolicy> mtx;
+    std::atomic<bool> held_by_other_thread = false;
+
+    std::thread other_thread([&] {
+        std::unique_lock lock(mtx);
+        held_by_other_thread = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    });
+
+    while (!held_by_other_thread)
+        /* wait for other_thread to lock mtx */;
+
+    std::unique_lock lock(mtx);
+    CHECK(lock.owns_lock());
+    other_thread.join();
+}
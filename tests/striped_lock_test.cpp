@@ -0,0 +1,149 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <crill/spin_mutex.h>
+#include <crill/striped_lock.h>
+#include <doctest/doctest.h>
+
+namespace
+{
+    // A mutex whose lock() throws once a given number of locks have succeeded.
+    struct throwing_mutex
+    {
+        void lock()
+        {
+            if (successful_locks_left-- == 0)
+                throw std::runtime_error("lock failed");
+
+            locked = true;
+        }
+
+        void unlock()
+        {
+            locked = false;
+        }
+
+        bool locked = false;
+        static inline int successful_locks_left = 0;
+    };
+}
+
+TEST_CASE("crill::striped_lock")
+{
+    using table_type = crill::striped_lock<crill::spin_mutex, 16>;
+    static_assert(sizeof(table_type) == 16 * CRILL_DESTRUCTIVE_INTERFERENCE_SIZE);
+    static_assert(table_type::size() == 16);
+
+    table_type table;
+
+    SUBCASE("The same key always maps to the same mutex")
+    {
+        CHECK(&table.lock_for(42) == &table.lock_for(42));
+        CHECK(&table.lock_for(std::string("abc")) == &table.lock_for(std::string("abc")));
+    }
+
+    SUBCASE("Consecutive keys are spread over the table")
+    {
+        std::vector<bool> used(table.size());
+        for (int key = 0; key < 64; ++key)
+            used[table_type::index_for(key)] = true;
+
+        int num_used = 0;
+        for (bool u : used)
+            num_used += u;
+
+        CHECK(num_used > 8);
+    }
+
+    SUBCASE("Works with std::scoped_lock")
+    {
+        {
+            std::scoped_lock lock(table.lock_for(1));
+            CHECK_FALSE(table.lock_for(1).try_lock());
+        }
+
+        CHECK(table.lock_for(1).try_lock());
+        table.lock_for(1).unlock();
+    }
+
+    SUBCASE("lock_keys locks all keys, and keys sharing a mutex only once")
+    {
+        int other_key = 1;
+        while (table_type::index_for(other_key) == table_type::index_for(0))
+            ++other_key;
+
+        {
+            auto lock = table.lock_keys(0, other_key, 0);
+            CHECK_FALSE(table.lock_for(0).try_lock());
+            CHECK_FALSE(table.lock_for(other_key).try_lock());
+        }
+
+        CHECK(table.lock_for(0).try_lock());
+        table.lock_for(0).unlock();
+        CHECK(table.lock_for(other_key).try_lock());
+        table.lock_for(other_key).unlock();
+    }
+
+    SUBCASE("lock_key_range locks all keys in the range")
+    {
+        std::vector<int> keys = { 3, 1, 4, 1, 5, 9, 2, 6 };
+        {
+            auto lock = table.lock_key_range(keys.begin(), keys.end());
+            for (int key : keys)
+                CHECK_FALSE(table.lock_for(key).try_lock());
+        }
+
+        for (int key : keys)
+        {
+            CHECK(table.lock_for(key).try_lock());
+            table.lock_for(key).unlock();
+        }
+    }
+
+    SUBCASE("Locking overlapping sets of keys in different orders does not deadlock")
+    {
+        const int num_iterations = 10'000;
+        int a = 0, b = 0;
+
+        std::thread other_thread([&]{
+            for (int i = 0; i < num_iterations; ++i)
+            {
+                auto lock = table.lock_keys(2, 1);
+                ++a;
+                ++b;
+            }
+        });
+
+        for (int i = 0; i < num_iterations; ++i)
+        {
+            auto lock = table.lock_keys(1, 2);
+            ++a;
+            ++b;
+        }
+
+        other_thread.join();
+        CHECK(a == 2 * num_iterations);
+        CHECK(b == 2 * num_iterations);
+    }
+}
+
+TEST_CASE("crill::striped_lock unlocks the mutexes locked so far if locking throws")
+{
+    crill::striped_lock<throwing_mutex, 8> table;
+    std::vector<int> keys;
+    for (int key = 0; key < 64; ++key)
+        keys.push_back(key);
+
+    throwing_mutex::successful_locks_left = 2;
+    CHECK_THROWS_AS((void)table.lock_key_range(keys.begin(), keys.end()), std::runtime_error);
+
+    for (int key : keys)
+        CHECK_FALSE(table.lock_for(key).locked);
+}
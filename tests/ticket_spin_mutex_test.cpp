@@ -0,0 +1,118 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <crill/ticket_spin_mutex.h>
+#include <doctest/doctest.h>
+
+TEST_CASE("crill::ticket_spin_mutex")
+{
+    static_assert(std::is_default_constructible_v<crill::ticket_spin_mutex>);
+    static_assert(!std::is_copy_constructible_v<crill::ticket_spin_mutex>);
+    static_assert(!std::is_copy_assignable_v<crill::ticket_spin_mutex>);
+    static_assert(!std::is_move_constructible_v<crill::ticket_spin_mutex>);
+    static_assert(!std::is_move_assignable_v<crill::ticket_spin_mutex>);
+
+    crill::ticket_spin_mutex mtx;
+
+    SUBCASE("If mutex is not locked, try_lock succeeds")
+    {
+        REQUIRE(mtx.try_lock());
+        mtx.unlock();
+    }
+
+    SUBCASE("If mutex is locked, try_lock fails")
+    {
+        mtx.lock();
+        REQUIRE_FALSE(mtx.try_lock());
+        mtx.unlock();
+        REQUIRE(mtx.try_lock());
+        mtx.unlock();
+    }
+
+    SUBCASE("Works with std::scoped_lock")
+    {
+        {
+            std::scoped_lock lock(mtx);
+            CHECK_FALSE(mtx.try_lock());
+        }
+
+        CHECK(mtx.try_lock());
+        mtx.unlock();
+    }
+
+    SUBCASE("If mutex is held by other thread, lock succeeds after mutex is released")
+    {
+        std::atomic<bool> held_by_other_thread = false;
+
+        std::thread other_thread([&] {
+            std::unique_lock lock(mtx);
+            held_by_other_thread = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        });
+
+        while (!held_by_other_thread)
+            /* wait for other_thread to lock mtx */;
+
+        std::unique_lock lock(mtx);
+        CHECK(lock.owns_lock());
+        other_thread.join();
+    }
+
+    SUBCASE("Waiting threads acquire the lock in FIFO order")
+    {
+        const int num_threads = 4;
+        std::vector<int> order;
+        std::vector<std::thread> threads;
+
+        mtx.lock();
+        for (int i = 0; i < num_threads; ++i)
+        {
+            threads.emplace_back([&, i]{
+                std::scoped_lock lock(mtx);
+                order.push_back(i);
+            });
+
+            // give thread i enough time to take its ticket
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+
+        CHECK_FALSE(mtx.try_lock());
+        mtx.unlock();
+
+        for (auto& thread : threads)
+            thread.join();
+
+        REQUIRE(order.size() == num_threads);
+        for (int i = 0; i < num_threads; ++i)
+            CHECK(order[i] == i);
+    }
+
+    SUBCASE("Many threads incrementing a counter")
+    {
+        const int num_threads = 4;
+        const int num_iterations = 1000;
+        int counter = 0;
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < num_threads; ++i)
+        {
+            threads.emplace_back([&]{
+                for (int j = 0; j < num_iterations; ++j)
+                {
+                    std::scoped_lock lock(mtx);
+                    ++counter;
+                }
+            });
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        CHECK(counter == num_threads * num_iterations);
+    }
+}
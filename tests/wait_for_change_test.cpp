@@ -0,0 +1,37 @@
+// crill - the Cross-platform Real-time, I/O, and Low-Latency Library
+// Copyright (c) 2022 - Timur Doumler and Fabian Renn-Giles
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.md or copy at http://boost.org/LICENSE_1_0.txt)
+
+#include <atomic>
+#include <thread>
+#include <crill/wait_for_change.h>
+#include <doctest/doctest.h>
+
+TEST_CASE("Waiting for change of a value that already differs immediately returns")
+{
+    std::atomic<int> value = 1;
+    crill::wait_for_change(value, 0);
+}
+
+TEST_CASE("Waiting for change blocks until the value changes")
+{
+    std::atomic<int> value = 0;
+    std::atomic<bool> waiter_thread_running = false;
+    std::atomic<bool> waiter_thread_done = false;
+    std::thread waiter_thread([&]{
+        waiter_thread_running = true;
+        crill::wait_for_change(value, 0);
+        waiter_thread_done = true;
+    });
+
+    while (!waiter_thread_running)
+        /* wait for thread to start*/;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    REQUIRE_FALSE(waiter_thread_done);
+
+    value = 1;
+    waiter_thread.join();
+    REQUIRE(waiter_thread_done);
+}